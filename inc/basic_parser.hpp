@@ -0,0 +1,256 @@
+// This file is a part of the IncludeOS unikernel - www.includeos.org
+//
+// Copyright 2015-2016 Oslo and Akershus University College of Applied Sciences
+// and Alfred Bratterud
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef HTTP_BASIC_PARSER_HPP
+#define HTTP_BASIC_PARSER_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+#include <http_parser.h>
+
+#include "span.hpp"
+#include "common.hpp"
+
+//----------------------------------------
+// The parse loop of the underlying parser over
+// the type of its settings, defined in
+// <http_parser_execute.hpp>
+//----------------------------------------
+namespace http_parser_detail {
+template <typename Settings>
+size_t execute(http_parser *parser, const Settings *settings, const char *data, size_t len);
+} //< namespace http_parser_detail
+
+namespace http {
+
+//----------------------------------------
+// The events of the underlying parser with
+// an empty implementation
+//
+// A handler derives from this class and hides
+// the events it is interested in with members
+// of the same signature. Events that are not
+// hidden are left out of the parse loop so
+// they cost nothing
+//----------------------------------------
+struct Parser_handler {
+  int on_message_begin(http_parser&) noexcept
+  { return 0; }
+
+  int on_url(http_parser&, const char*, size_t) noexcept
+  { return 0; }
+
+  int on_status(http_parser&, const char*, size_t) noexcept
+  { return 0; }
+
+  int on_header_field(http_parser&, const char*, size_t) noexcept
+  { return 0; }
+
+  int on_header_value(http_parser&, const char*, size_t) noexcept
+  { return 0; }
+
+  int on_headers_complete(http_parser&) noexcept
+  { return 0; }
+
+  int on_body(http_parser&, const char*, size_t) noexcept
+  { return 0; }
+
+  int on_message_complete(http_parser&) noexcept
+  { return 0; }
+
+  int on_chunk_header(http_parser&) noexcept
+  { return 0; }
+
+  int on_chunk_complete(http_parser&) noexcept
+  { return 0; }
+}; //< struct Parser_handler
+
+//----------------------------------------
+// This class is used to drive the underlying
+// parser with a handler type whose events are
+// known at compile time
+//
+// The parse loop is instantiated for each handler
+// type with the events of the handler in place of
+// the function pointers of the parser settings, so
+// the events that are not hidden are dropped from
+// the loop and the others are inlined into it
+//
+// The loop is defined in <http_parser_execute.hpp>,
+// which is included by the source calling <execute>
+//
+// @tparam Handler - A type derived from <Parser_handler>
+//----------------------------------------
+template <typename Handler>
+class Basic_parser {
+public:
+  //----------------------------------------
+  // Run the underlying parser over the
+  // specified data
+  //
+  // @param handler - The handler to receive the events
+  // @param parser  - The parser state
+  // @param data    - The data to parse
+  // @param len     - The length of the data
+  //
+  // @return - The number of bytes parsed
+  //----------------------------------------
+  static size_t execute(Handler& handler, http_parser& parser,
+                        const char* data, const size_t len) noexcept;
+private:
+  //----------------------------------------
+  // Check if the handler hides the event
+  // of <Parser_handler>
+  //----------------------------------------
+  template <typename Event, typename Base_event>
+  static constexpr bool handles(Event, Base_event) noexcept
+  { return not std::is_same<Event, Base_event>::value; }
+
+  //----------------------------------------
+  // The events of the handler as the parse
+  // loop uses the parser settings
+  //
+  // An event tests as whether the handler
+  // hides it, which is a constant, and a call
+  // goes straight to the handler
+  //----------------------------------------
+#define HTTP_NOTIFY_EVENT(event)                                            \
+  struct {                                                                  \
+    Handler& handler;                                                       \
+    constexpr explicit operator bool() const noexcept                       \
+    { return handles(&Handler::event, &Parser_handler::event); }            \
+    int operator()(http_parser* parser) const                               \
+    { return handler.event(*parser); }                                      \
+  } event
+
+#define HTTP_DATA_EVENT(event)                                              \
+  struct {                                                                  \
+    Handler& handler;                                                       \
+    constexpr explicit operator bool() const noexcept                       \
+    { return handles(&Handler::event, &Parser_handler::event); }            \
+    int operator()(http_parser* parser, const char* at, size_t length) const\
+    { return handler.event(*parser, at, length); }                          \
+  } event
+
+  struct Events {
+    HTTP_NOTIFY_EVENT(on_message_begin);
+    HTTP_DATA_EVENT(on_url);
+    HTTP_DATA_EVENT(on_status);
+    HTTP_DATA_EVENT(on_header_field);
+    HTTP_DATA_EVENT(on_header_value);
+    HTTP_NOTIFY_EVENT(on_headers_complete);
+    HTTP_DATA_EVENT(on_body);
+    HTTP_NOTIFY_EVENT(on_message_complete);
+    HTTP_NOTIFY_EVENT(on_chunk_header);
+    HTTP_NOTIFY_EVENT(on_chunk_complete);
+  }; //< struct Events
+
+#undef HTTP_DATA_EVENT
+#undef HTTP_NOTIFY_EVENT
+}; //< class Basic_parser
+
+//----------------------------------------
+// Get what the parser found out about the
+// current message
+//
+// Should be called from <on_headers_complete>
+//
+// @param parser - The parser state
+//
+// @return - The framing and connection of
+//           the message
+//----------------------------------------
+Message_info message_info(const http_parser& parser) noexcept;
+
+//----------------------------------------
+// Join the lines of a folded field value
+// with a single space each
+//
+// The value is rewritten in place towards
+// its end, so the bytes it no longer needs
+// become whitespace in front of it and the
+// line it is on stays well formed
+//
+// @param begin - The start of the value
+// @param end   - The end of its last line
+//
+// @return - The unfolded value
+//----------------------------------------
+span unfold_value(char* const begin, char* const end) noexcept;
+
+/**--v----------- Implementation Details -----------v--**/
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename Handler>
+inline size_t Basic_parser<Handler>::execute(Handler& handler, http_parser& parser,
+                                             const char* data, const size_t len) noexcept {
+  const Events events {
+    {handler}, {handler}, {handler}, {handler}, {handler},
+    {handler}, {handler}, {handler}, {handler}, {handler}
+  };
+  return http_parser_detail::execute(&parser, &events, data, len);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+inline Message_info message_info(const http_parser& parser) noexcept {
+  Message_info info;
+  //-----------------------------------
+  if (parser.flags & F_CONTENTLENGTH) {
+    info.content_length = parser.content_length;
+    info.flags |= Message_info::Content_length;
+  }
+  //-----------------------------------
+  if (parser.flags & F_CHUNKED)          info.flags |= Message_info::Chunked;
+  if (parser.flags & F_CONNECTION_CLOSE) info.flags |= Message_info::Close;
+  if (parser.upgrade)                    info.flags |= Message_info::Upgrade;
+  if (http_should_keep_alive(&parser))   info.flags |= Message_info::Keep_alive;
+  //-----------------------------------
+  return info;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+inline span unfold_value(char* const begin, char* const end) noexcept {
+  const auto size = static_cast<size_t>(end - begin);
+  //-----------------------------------
+  if (std::memchr(begin, '\n', size) == nullptr) return {begin, size};
+  //-----------------------------------
+  char* out = begin;
+  //-----------------------------------
+  for (const char* p = begin; p < end;) {
+    if (*p not_eq '\r' and *p not_eq '\n') {
+      *out++ = *p++;
+      continue;
+    }
+    while (p < end and (*p == '\r' or *p == '\n')) ++p;
+    while (p < end and (*p == ' '  or *p == '\t')) ++p;
+    *out++ = ' ';
+  }
+  //-----------------------------------
+  const auto len = static_cast<size_t>(out - begin);
+  std::memmove(end - len, begin, len);
+  std::memset(begin, ' ', size - len);
+  //-----------------------------------
+  return {end - len, len};
+}
+
+/**--^----------- Implementation Details -----------^--**/
+
+} //< namespace http
+
+#endif //< HTTP_BASIC_PARSER_HPP
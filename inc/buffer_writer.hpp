@@ -0,0 +1,200 @@
+// This file is a part of the IncludeOS unikernel - www.includeos.org
+//
+// Copyright 2015-2016 Oslo and Akershus University College of Applied Sciences
+// and Alfred Bratterud
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef HTTP_BUFFER_WRITER_HPP
+#define HTTP_BUFFER_WRITER_HPP
+
+#include <cstddef>
+#include <cstring>
+
+#include "span.hpp"
+#include "version.hpp"
+
+namespace http {
+
+//-----------------------------------------------
+// The decimal digits of every number below 1000,
+// three characters each, so numbers are written
+// without storage of their own
+//-----------------------------------------------
+template <typename = void>
+struct Decimal_table {
+  struct Digits {
+    char text[3000];
+  };
+
+  static constexpr Digits make() noexcept {
+    Digits digits {};
+    for (unsigned i = 0; i < 1000; ++i) {
+      digits.text[i * 3]     = static_cast<char>('0' + i / 100);
+      digits.text[i * 3 + 1] = static_cast<char>('0' + i / 10 % 10);
+      digits.text[i * 3 + 2] = static_cast<char>('0' + i % 10);
+    }
+    return digits;
+  }
+
+  static constexpr Digits digits {make()};
+};
+
+template <typename T>
+constexpr typename Decimal_table<T>::Digits Decimal_table<T>::digits;
+
+//-----------------------------------------------
+// This class is used to write a message into a
+// buffer of known size with plain copies
+//
+// Writing stops at the first piece that doesn't
+// fit, which is then reported by <fits>
+//-----------------------------------------------
+class Buffer_writer {
+public:
+  //-----------------------------------------------
+  // Constructor
+  //
+  // @param buffer - The buffer to write into
+  // @param len    - The size of the buffer
+  //-----------------------------------------------
+  Buffer_writer(char* buffer, const size_t len) noexcept;
+
+  //-----------------------------------------------
+  // Write a piece at the end of the data
+  //
+  // @param data - The piece to write
+  //-----------------------------------------------
+  void add(const span& data) noexcept;
+
+  //-----------------------------------------------
+  // Write a number in decimal at the end of
+  // the data
+  //
+  // @param number - The number to write
+  //-----------------------------------------------
+  void add(const unsigned number) noexcept;
+
+  //-----------------------------------------------
+  // Write a version at the end of the data,
+  // such as "HTTP/1.1"
+  //
+  // @param version - The version to write
+  //-----------------------------------------------
+  void add(const Version& version) noexcept;
+
+  //-----------------------------------------------
+  // Get the number of bytes written
+  //
+  // @return - The number of bytes written
+  //-----------------------------------------------
+  size_t size() const noexcept;
+
+  //-----------------------------------------------
+  // Check if everything written so far fit
+  // into the buffer
+  //
+  // @return - true if it fit, false otherwise
+  //-----------------------------------------------
+  bool fits() const noexcept;
+
+  //-----------------------------------------------
+  // Get the number of bytes <add> writes for
+  // a number
+  //-----------------------------------------------
+  static size_t size_of(const unsigned number) noexcept;
+
+  //-----------------------------------------------
+  // Get the number of bytes <add> writes for
+  // a version
+  //-----------------------------------------------
+  static size_t size_of(const Version& version) noexcept;
+private:
+  char* const begin_;
+  char*       at_;
+  char* const end_;
+  bool        fits_ {true};
+}; //< class Buffer_writer
+
+/**--v----------- Implementation Details -----------v--**/
+
+///////////////////////////////////////////////////////////////////////////////
+inline Buffer_writer::Buffer_writer(char* buffer, const size_t len) noexcept
+  : begin_{buffer}
+  , at_{buffer}
+  , end_{buffer + len}
+{}
+
+///////////////////////////////////////////////////////////////////////////////
+inline void Buffer_writer::add(const span& data) noexcept {
+  if (not fits_ or static_cast<size_t>(end_ - at_) < data.len) {
+    fits_ = false;
+    return;
+  }
+  //-----------------------------------
+  if (data.len not_eq 0) std::memcpy(at_, data.data, data.len);
+  at_ += data.len;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+inline void Buffer_writer::add(const unsigned number) noexcept {
+  const auto text = Decimal_table<>::digits.text;
+  //-----------------------------------
+  if (number >= 1000) {
+    add(number / 1000);
+    add({text + (number % 1000) * 3, 3});
+    return;
+  }
+  //-----------------------------------
+  const auto len = size_of(number);
+  add({text + number * 3 + (3 - len), len});
+}
+
+///////////////////////////////////////////////////////////////////////////////
+inline void Buffer_writer::add(const Version& version) noexcept {
+  add({"HTTP/", 5});
+  add(version.get_major());
+  add({".", 1});
+  add(version.get_minor());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+inline size_t Buffer_writer::size() const noexcept {
+  return at_ - begin_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+inline bool Buffer_writer::fits() const noexcept {
+  return fits_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+inline size_t Buffer_writer::size_of(unsigned number) noexcept {
+  size_t len = 1;
+  while (number >= 10) {
+    number /= 10;
+    ++len;
+  }
+  return len;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+inline size_t Buffer_writer::size_of(const Version& version) noexcept {
+  return 6 + size_of(version.get_major()) + size_of(version.get_minor());
+}
+
+/**--^----------- Implementation Details -----------^--**/
+
+} //< namespace http
+
+#endif //< HTTP_BUFFER_WRITER_HPP
@@ -34,8 +34,41 @@ using HeaderSet = std::vector<std::pair<CString, CString>>;
 
 using buffer_t = std::shared_ptr<uint8_t>;
 
+//------------------------------------------------
+// Options to control how a message is parsed
+//------------------------------------------------
+enum Parse_options : unsigned {
+  Parse_default   = 0,
+  Lazy_headers    = 1 << 0, //< Index the header block on first access
+  In_place_chunks = 1 << 1, //< Decode a chunked body within the owned buffer
+  Zero_copy_body  = 1 << 2  //< Refer to a Content-Length body within the owned buffer
+};
+
+constexpr Parse_options operator | (const Parse_options lhs, const Parse_options rhs) noexcept {
+  return static_cast<Parse_options>(static_cast<unsigned>(lhs) | static_cast<unsigned>(rhs));
+}
+
+//------------------------------------------------
+// What the parser found out about the framing
+// and connection of a message, so it doesn't
+// have to be recovered from the fields
+//------------------------------------------------
+struct Message_info {
+  enum Flags : uint8_t {
+    Content_length = 1 << 0, //< The length of the entity is known
+    Chunked        = 1 << 1, //< The entity is sent in chunks
+    Keep_alive     = 1 << 2, //< The connection persists after the message
+    Close          = 1 << 3, //< Connection: close was received
+    Upgrade        = 1 << 4  //< The connection switches protocol
+  };
+
+  uint64_t content_length {0};
+  uint8_t  flags          {0};
+};
+
 class Request;
 using Request_ptr = std::shared_ptr<Request>;
+using Request_list = std::vector<Request_ptr>;
 
 class Response;
 using Response_ptr = std::shared_ptr<Response>;
@@ -22,12 +22,16 @@
 #include <vector>
 #include <cstring>
 #include <utility>
+#include <iterator>
 #include <ostream>
 #include <algorithm>
 #include <type_traits>
 
 #include "span.hpp"
 #include "common.hpp"
+#include "offset_span.hpp"
+#include "small_vector.hpp"
+#include "header_fields.hpp"
 
 namespace http {
 
@@ -38,17 +42,51 @@ namespace http {
 // By default it is limited to 100 fields
 // but the amount can be specified by using the
 // appropriate constructor and provided method.
+//
+// The limit doesn't allocate anything, the
+// first <Inline_fields> fields are stored
+// within the object itself
+//
+// Fields are stored relative to the buffers
+// of the message, which are passed in by the
+// methods that convert spans, so the set can be
+// copied along with them and reading it doesn't
+// write to it
+//
+// The fields are kept as parallel arrays, so a
+// lookup scans the dense identifiers and name
+// hashes and only touches the names and values
+// of the fields that match
 //-----------------------------------------------
 class Header {
 private:
   //-----------------------------------------------
   // Internal class type aliases
   //-----------------------------------------------
-  using Map_Type       = std::pair<span, span>;
-  using Field_Map      = std::vector<Map_Type>;
-  using Const_Iterator = Field_Map::const_iterator;
+  static constexpr Limit Inline_fields {16};
+  //-----------------------------------------------
+  using Span_Map = Small_vector<Compact_span, Inline_fields>;
+  using Id_Map   = Small_vector<header::Field_id, Inline_fields>;
+  using Key_Map  = Small_vector<uint16_t, Inline_fields>;
+  //-----------------------------------------------
+  // A field name prepared for repeated lookups
+  //-----------------------------------------------
+  struct Lookup {
+    span             field;
+    header::Field_id id;
+    uint16_t         key;
+  };
   //-----------------------------------------------
 public:
+  //-----------------------------------------------
+  // A field as (name, value), referring to the
+  // data of the message
+  //-----------------------------------------------
+  using Field_view = std::pair<span, span>;
+
+  class const_iterator;
+  class Fields;
+  class Value_range;
   //-----------------------------------------------
   // Default constructor that limits the amount
   // of fields that can be added to 100
@@ -94,11 +132,14 @@ public:
   //
   // @param field - The field name
   // @param value - The field value
+  // @param bases - The buffers of the message, the
+  //                spans that are not within them
+  //                are kept as they are
   //
   // @return - true if the field was added, false
   //           otherwise
   //-----------------------------------------------
-  bool add_field(const span& field, const span& value);
+  bool add_field(const span& field, const span& value, const Span_bases& bases = {});
 
   //-----------------------------------------------
   // Change the value of the specified field
@@ -109,21 +150,34 @@ public:
   //
   // @param field - The field name
   // @param value - The field value
+  // @param bases - The buffers of the message
   //
   // @return - true if successful, false otherwise
   //-----------------------------------------------
-  bool set_field(const span& field, const span& value);
+  bool set_field(const span& field, const span& value, const Span_bases& bases = {});
 
   //-----------------------------------------------
   // Check to see if the specified field is a
   // member of the set
   //
   // @param field - The field name
+  // @param bases - The buffers of the message
   //
   // @return - true if the field is a member,
   //           false otherwise
   //-----------------------------------------------
-  bool has_field(const span& field) const noexcept;
+  bool has_field(const span& field, const Span_bases& bases = {}) const noexcept;
+
+  //-----------------------------------------------
+  // Check to see if the specified well-known
+  // field is a member of the set
+  //
+  // @param field - The well-known field
+  //
+  // @return - true if the field is a member,
+  //           false otherwise
+  //-----------------------------------------------
+  bool has_field(const header::Field& field) const noexcept;
 
   //-----------------------------------------------
   // Get the value associated with a field
@@ -131,11 +185,99 @@ public:
   // Should call <has_field> before calling this
   //
   // @param field - The field name
+  // @param bases - The buffers of the message
   //
   // @return - The value associated with the
   //           specified field name
   //-----------------------------------------------
-  const span& get_value(const span& field) const noexcept;
+  span get_value(const span& field, const Span_bases& bases = {}) const noexcept;
+
+  //-----------------------------------------------
+  // Get the value associated with a well-known
+  // field
+  //
+  // Should call <has_field> before calling this
+  //
+  // @param field - The well-known field
+  // @param bases - The buffers of the message
+  //
+  // @return - The value associated with the
+  //           specified field
+  //-----------------------------------------------
+  span get_value(const header::Field& field, const Span_bases& bases = {}) const noexcept;
+
+  //-----------------------------------------------
+  // Find the value associated with a field in
+  // a single pass over the set
+  //
+  // @param field - The field name
+  // @param bases - The buffers of the message
+  //
+  // @return - The value associated with the
+  //           specified field name, without data
+  //           if the field is not a member
+  //-----------------------------------------------
+  span find_value(const span& field, const Span_bases& bases = {}) const noexcept;
+
+  //-----------------------------------------------
+  // Find the value associated with a well-known
+  // field in a single pass over the set
+  //
+  // @param field - The well-known field
+  // @param bases - The buffers of the message
+  //
+  // @return - The value associated with the
+  //           specified field, without data if
+  //           the field is not a member
+  //-----------------------------------------------
+  span find_value(const header::Field& field, const Span_bases& bases = {}) const noexcept;
+
+  //-----------------------------------------------
+  // Get the values of every field with the
+  // specified name, in the order they were added
+  //
+  // Fields such as Set-Cookie or Via may be
+  // repeated instead of combined into one
+  //
+  // @param field - The field name
+  // @param bases - The buffers of the message
+  //
+  // @return - A range over the values, empty if
+  //           the field is not a member
+  //-----------------------------------------------
+  Value_range get_values(const span& field, const Span_bases& bases = {}) const noexcept;
+
+  //-----------------------------------------------
+  // Get the values of every field with the
+  // specified well-known name
+  //
+  // @param field - The well-known field
+  // @param bases - The buffers of the message
+  //
+  // @return - A range over the values, empty if
+  //           the field is not a member
+  //-----------------------------------------------
+  Value_range get_values(const header::Field& field, const Span_bases& bases = {}) const noexcept;
+
+  //-----------------------------------------------
+  // Get the fields, which can be iterated in the
+  // order they were added
+  //
+  // The iterators are invalidated by any change
+  // to the set or to the message
+  //
+  // @param bases - The buffers of the message
+  //
+  // @return - A range over the fields
+  //-----------------------------------------------
+  Fields fields(const Span_bases& bases = {}) const noexcept;
+
+  //-----------------------------------------------
+  // Iterate over the fields of a set that is
+  // not relative to the buffers of a message
+  //-----------------------------------------------
+  const_iterator begin() const noexcept;
+  const_iterator end()   const noexcept;
 
   //-----------------------------------------------
   // Check to see if the set is empty
@@ -159,8 +301,9 @@ public:
   // specified name
   //
   // @param field - The field name to remove
+  // @param bases - The buffers of the message
   //-----------------------------------------------
-  void erase(const span& field) noexcept;
+  void erase(const span& field, const Span_bases& bases = {}) noexcept;
 
   //-----------------------------------------------
   // Remove all fields from the set leaving it
@@ -171,18 +314,103 @@ private:
   //-----------------------------------------------
   // Class data members
   //-----------------------------------------------
-  Field_Map map_;
+  Span_Map names_;
+  Span_Map values_;
+  Limit    limit_;
+
+  //-----------------------------------------------
+  // The spans that don't fit into a compact span,
+  // such as those of fields added by the program
+  //-----------------------------------------------
+  std::vector<span> external_;
+
+  //-----------------------------------------------
+  // The identifier of each field, so well-known
+  // fields are found by comparing integers
+  //-----------------------------------------------
+  Id_Map ids_;
+
+  //-----------------------------------------------
+  // The name hash of each field folded to 16 bits,
+  // so other fields are only compared by name when
+  // their key matches
+  //-----------------------------------------------
+  Key_Map keys_;
+
+  //-----------------------------------------------
+  // Convert a span for storage in the set
+  //
+  // @param s        - The span to convert
+  // @param bases    - The buffers of the message
+  // @param previous - A span this replaces, if any,
+  //                   whose storage can be reused
+  //
+  // @return - The compact span
+  //-----------------------------------------------
+  Compact_span compact(const span& s, const Span_bases& bases,
+                       const Compact_span* previous = nullptr);
+
+  //-----------------------------------------------
+  // Convert a span from the set for use
+  //
+  // @param c     - The compact span to convert
+  // @param bases - The buffers of the message
+  //
+  // @return - The span
+  //-----------------------------------------------
+  span expand(const Compact_span& c, const Span_bases& bases) const noexcept;
 
   //-----------------------------------------------
   // Find the location of a field within the set
   //
   // @param field - The field name to locate
+  // @param bases - The buffers of the message
+  //
+  // @return - Index of the field, else the size
+  //           of the set
+  //-----------------------------------------------
+  size_t find(const span& field, const Span_bases& bases) const noexcept;
+
+  //-----------------------------------------------
+  // Prepare a field name for <find>
+  //
+  // @param field - The field name
+  //
+  // @return - The field name with its identifier
+  //           and key
+  //-----------------------------------------------
+  static Lookup prepare(const span& field) noexcept;
+
+  //-----------------------------------------------
+  // Find the next location of a field within
+  // the set
+  //
+  // @param lookup - The prepared field name
+  // @param from   - Index to start searching at
+  // @param bases  - The buffers of the message
+  //
+  // @return - Index of the field, else the size
+  //           of the set
+  //-----------------------------------------------
+  size_t find(const Lookup& lookup, const size_t from, const Span_bases& bases) const noexcept;
+
+  //-----------------------------------------------
+  // Find the location of a well-known field
+  // within the set
+  //
+  // @param id - The identifier of the field
   //
-  // @return - Iterator to the location of the field,
-  //           else location to the end of the
-  //           sequence
+  // @return - Index of the field, else the size
+  //           of the set
   //-----------------------------------------------
-  Const_Iterator find(const span& field) const noexcept;
+  size_t find(const header::Field_id id) const noexcept;
+
+  //-----------------------------------------------
+  // Remove the field at the specified location
+  //
+  // @param index - Index of the field
+  //-----------------------------------------------
+  void erase(const size_t index) noexcept;
 
   //-----------------------------------------------
   // Operator to stream the contents of the set
@@ -194,6 +422,174 @@ private:
   friend std::ostream& operator << (std::ostream&, const Header&);
 }; //< class Header
 
+//-----------------------------------------------
+// Iterator over the fields of a set
+//-----------------------------------------------
+class Header::const_iterator {
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type        = Field_view;
+  using difference_type   = std::ptrdiff_t;
+  using pointer           = void;
+  using reference         = Field_view;
+
+  const_iterator() noexcept = default;
+
+  Field_view operator * () const noexcept
+  { return {header_->expand(header_->names_[index_], bases_),
+            header_->expand(header_->values_[index_], bases_)}; }
+
+  const_iterator& operator ++ () noexcept
+  { ++index_; return *this; }
+
+  const_iterator operator ++ (int) noexcept
+  { auto previous = *this; ++index_; return previous; }
+
+  bool operator == (const const_iterator& other) const noexcept
+  { return index_ == other.index_; }
+
+  bool operator != (const const_iterator& other) const noexcept
+  { return index_ not_eq other.index_; }
+private:
+  const Header* header_ {nullptr};
+  Span_bases    bases_;
+  size_t        index_  {0};
+
+  const_iterator(const Header* header, const Span_bases& bases, const size_t index) noexcept
+    : header_{header}
+    , bases_{bases}
+    , index_{index}
+  {}
+
+  friend class Header;
+  friend class Fields;
+}; //< class Header::const_iterator
+
+//-----------------------------------------------
+// Range over the fields of a set, resolved
+// against the buffers of a message
+//-----------------------------------------------
+class Header::Fields {
+public:
+  const_iterator begin() const noexcept
+  { return {header_, bases_, 0}; }
+
+  const_iterator end() const noexcept
+  { return {header_, bases_, header_->size()}; }
+
+  Limit size()  const noexcept { return header_->size(); }
+  bool  empty() const noexcept { return header_->is_empty(); }
+private:
+  const Header* header_;
+  Span_bases    bases_;
+
+  Fields(const Header* header, const Span_bases& bases) noexcept
+    : header_{header}
+    , bases_{bases}
+  {}
+
+  friend class Header;
+}; //< class Header::Fields
+
+//-----------------------------------------------
+// Range over the values of the fields of a set
+// that have the same name
+//-----------------------------------------------
+class Header::Value_range {
+public:
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = span;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = void;
+    using reference         = span;
+
+    const_iterator() noexcept = default;
+
+    span operator * () const noexcept
+    { return header_->expand(header_->values_[index_], bases_); }
+
+    const_iterator& operator ++ () noexcept
+    { index_ = header_->find(lookup_, index_ + 1, bases_); return *this; }
+
+    const_iterator operator ++ (int) noexcept
+    { auto previous = *this; ++*this; return previous; }
+
+    bool operator == (const const_iterator& other) const noexcept
+    { return index_ == other.index_; }
+
+    bool operator != (const const_iterator& other) const noexcept
+    { return index_ not_eq other.index_; }
+  private:
+    const Header* header_ {nullptr};
+    Span_bases    bases_;
+    Lookup        lookup_ {};
+    size_t        index_  {0};
+
+    const_iterator(const Header* header, const Span_bases& bases, const Lookup& lookup,
+                   const size_t index) noexcept
+      : header_{header}
+      , bases_{bases}
+      , lookup_{lookup}
+      , index_{index}
+    {}
+
+    friend class Value_range;
+  }; //< class Header::Value_range::const_iterator
+
+  const_iterator begin() const noexcept
+  { return {header_, bases_, lookup_, header_->find(lookup_, 0, bases_)}; }
+
+  const_iterator end() const noexcept
+  { return {header_, bases_, lookup_, header_->size()}; }
+
+  bool empty() const noexcept
+  { return begin() == end(); }
+private:
+  const Header* header_;
+  Span_bases    bases_;
+  Lookup        lookup_;
+
+  Value_range(const Header* header, const Span_bases& bases, const Lookup& lookup) noexcept
+    : header_{header}
+    , bases_{bases}
+    , lookup_{lookup}
+  {}
+
+  friend class Header;
+}; //< class Header::Value_range
+
+/**--v----------- Implementation Details -----------v--**/
+
+///////////////////////////////////////////////////////////////////////////////
+inline Header::Value_range Header::get_values(const span& field, const Span_bases& bases) const noexcept {
+  return {this, bases, prepare(field)};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+inline Header::Value_range Header::get_values(const header::Field& field,
+                                              const Span_bases& bases) const noexcept {
+  return {this, bases, {field, field.id, header::key(field.hash)}};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+inline Header::Fields Header::fields(const Span_bases& bases) const noexcept {
+  return {this, bases};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+inline Header::const_iterator Header::begin() const noexcept {
+  return {this, Span_bases{}, 0};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+inline Header::const_iterator Header::end() const noexcept {
+  return {this, Span_bases{}, size()};
+}
+
+/**--^----------- Implementation Details -----------^--**/
+
 } //< namespace http
 
 #endif //< HTTP_HEADER_HPP
@@ -15,65 +15,163 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+
 #ifndef HTTP_HEADER_FIELDS_HPP
 #define HTTP_HEADER_FIELDS_HPP
 
+#include <cstddef>
+#include <cstdint>
+
+#include "span.hpp"
+
 namespace http {
 namespace header {
 //------------------------------------------------
-using Field = const char*;
-//------------------------------------------------
-// Request Fields
-//------------------------------------------------
-extern Field Accept;
-extern Field Accept_Charset;
-extern Field Accept_Encoding;
-extern Field Accept_Language;
-extern Field Authorization;
-extern Field Connection;
-extern Field Expect;
-extern Field From;
-extern Field Host;
-extern Field HTTP2_Settings;
-extern Field If_Match;
-extern Field If_Modified_Since;
-extern Field If_None_Match;
-extern Field If_Range;
-extern Field If_Unmodified_Since;
-extern Field Max_Forwards;
-extern Field Proxy_Authorization;
-extern Field Range;
-extern Field Referer;
-extern Field TE;
-extern Field Upgrade;
-extern Field User_Agent;
-//------------------------------------------------
-// Response Fields
-//------------------------------------------------
-extern Field Accept_Ranges;
-extern Field Age;
-extern Field Date;
-extern Field ETag;
-extern Field Location;
-extern Field Proxy_Authenticate;
-extern Field Retry_After;
-extern Field Server;
-extern Field Vary;
-extern Field WWW_Authenticate;
-//------------------------------------------------
-// Entity Fields
-//------------------------------------------------
-extern Field Allow;
-extern Field Content_Encoding;
-extern Field Content_Language;
-extern Field Content_Length;
-extern Field Content_Location;
-extern Field Content_MD5;
-extern Field Content_Range;
-extern Field Content_Type;
-extern Field Expires;
-extern Field Last_Modified;
+// The well-known fields, as (identifier, name)
+//------------------------------------------------
+#define HTTP_HEADER_FIELD_MAP(XX)                  \
+  /* Request Fields */                             \
+  XX(Accept,              "Accept")                \
+  XX(Accept_Charset,      "Accept-Charset")        \
+  XX(Accept_Encoding,     "Accept-Encoding")       \
+  XX(Accept_Language,     "Accept-Language")       \
+  XX(Authorization,       "Authorization")         \
+  XX(Connection,          "Connection")            \
+  XX(Expect,              "Expect")                \
+  XX(From,                "From")                  \
+  XX(Host,                "Host")                  \
+  XX(HTTP2_Settings,      "HTTP2-Settings")        \
+  XX(If_Match,            "If-Match")              \
+  XX(If_Modified_Since,   "If-Modified-Since")     \
+  XX(If_None_Match,       "If-None-Match")         \
+  XX(If_Range,            "If-Range")              \
+  XX(If_Unmodified_Since, "If-Unmodified-Since")   \
+  XX(Max_Forwards,        "Max-Forwards")          \
+  XX(Proxy_Authorization, "Proxy-Authorization")   \
+  XX(Range,               "Range")                 \
+  XX(Referer,             "Referer")               \
+  XX(TE,                  "TE")                    \
+  XX(Upgrade,             "Upgrade")               \
+  XX(User_Agent,          "User-Agent")            \
+  /* Response Fields */                            \
+  XX(Accept_Ranges,       "Accept-Ranges")         \
+  XX(Age,                 "Age")                   \
+  XX(Date,                "Date")                  \
+  XX(ETag,                "ETag")                  \
+  XX(Location,            "Location")              \
+  XX(Proxy_Authenticate,  "Proxy-Authenticate")    \
+  XX(Retry_After,         "Retry-After")           \
+  XX(Server,              "Server")                \
+  XX(Vary,                "Vary")                  \
+  XX(WWW_Authenticate,    "WWW-Authenticate")      \
+  /* Entity Fields */                              \
+  XX(Allow,               "Allow")                 \
+  XX(Content_Encoding,    "Content-Encoding")      \
+  XX(Content_Language,    "Content-Language")      \
+  XX(Content_Length,      "Content-Length")        \
+  XX(Content_Location,    "Content-Location")      \
+  XX(Content_MD5,         "Content-MD5")           \
+  XX(Content_Range,       "Content-Range")         \
+  XX(Content_Type,        "Content-Type")          \
+  XX(Expires,             "Expires")               \
+  XX(Last_Modified,       "Last-Modified")
+
+//------------------------------------------------
+// Identifies a well-known field, any other
+// field is <Field_id::Unknown>
+//------------------------------------------------
+enum class Field_id : uint8_t {
+  Unknown,
+#define XX(id, name) id,
+  HTTP_HEADER_FIELD_MAP(XX)
+#undef XX
+};
+
+//------------------------------------------------
+// Hash a field name regardless of case
+//
+// The seed is chosen so the well-known fields
+// hash to distinct slots of <Slots>, which
+// makes the hash perfect for them
+//------------------------------------------------
+constexpr uint32_t Seed  {2591};
+constexpr size_t   Slots {128};
+
+constexpr unsigned char fold(const char c) noexcept {
+  return static_cast<unsigned char>((c >= 'A' and c <= 'Z') ? c + ('a' - 'A') : c);
+}
+
+constexpr uint32_t hash(const char* name, const size_t len) noexcept {
+  uint32_t h = Seed;
+  for (size_t i = 0; i < len; ++i) {
+    h = (h ^ fold(name[i])) * 16777619U;
+  }
+  return h;
+}
+
+constexpr size_t slot(const uint32_t hash) noexcept {
+  return hash >> 25;
+}
+
+//------------------------------------------------
+// Fold a hash to 16 bits for dense tables that
+// are compared many entries at a time
+//------------------------------------------------
+constexpr uint16_t key(const uint32_t hash) noexcept {
+  return static_cast<uint16_t>(hash ^ (hash >> 16));
+}
+
+//------------------------------------------------
+// A well-known field name with its length, hash
+// and identifier known at compile time
+//------------------------------------------------
+struct Field {
+  const char* name;
+  size_t      len;
+  uint32_t    hash;
+  Field_id    id;
+
+  template <size_t N>
+  constexpr Field(const char (&field)[N], const Field_id field_id) noexcept
+    : name{field}
+    , len{N - 1}
+    , hash{header::hash(field, N - 1)}
+    , id{field_id}
+  {}
+
+  operator span () const noexcept
+  { return {name, len}; }
+};
+
+//------------------------------------------------
+// The well-known fields
+//------------------------------------------------
+#define XX(id, name) constexpr Field id {name, Field_id::id};
+HTTP_HEADER_FIELD_MAP(XX)
+#undef XX
+
+//------------------------------------------------
+// Classify a field name
+//
+// @param field - The field name
+//
+// @return - The identifier of the field, or
+//           <Field_id::Unknown> if it's not
+//           well-known
+//------------------------------------------------
+Field_id classify(const span& field) noexcept;
+
+//------------------------------------------------
+// Classify a field name that is already hashed
+//
+// @param field - The field name
+// @param hash  - The hash of the field name
+//
+// @return - The identifier of the field, or
+//           <Field_id::Unknown> if it's not
+//           well-known
 //------------------------------------------------
+Field_id classify(const span& field, const uint32_t hash) noexcept;
 //------------------------------------------------
 } //< namespace header
 } //< namespace http
@@ -0,0 +1,162 @@
+// This file is a part of the IncludeOS unikernel - www.includeos.org
+//
+// Copyright 2015-2016 Oslo and Akershus University College of Applied Sciences
+// and Alfred Bratterud
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef HTTP_IOVEC_LIST_HPP
+#define HTTP_IOVEC_LIST_HPP
+
+#include <cstddef>
+#include <sys/uio.h>
+
+#include "span.hpp"
+#include "version.hpp"
+#include "small_vector.hpp"
+#include "buffer_writer.hpp"
+
+namespace http {
+
+//-----------------------------------------------
+// This class is used to describe a message as
+// the pieces it is made of, for <writev>
+//
+// The pieces refer to static text and to the
+// data of the message, so it must not change
+// until the pieces are written
+//-----------------------------------------------
+class Iovec_list {
+public:
+  //-----------------------------------------------
+  // Enough for a message with about twenty fields
+  // without allocating
+  //-----------------------------------------------
+  static constexpr size_t Inline_entries {96};
+
+  //-----------------------------------------------
+  // Default constructor
+  //-----------------------------------------------
+  Iovec_list() noexcept = default;
+
+  //-----------------------------------------------
+  // Add a piece to the end of the list
+  //
+  // A piece that continues the previous one in
+  // memory is merged with it
+  //
+  // @param data - The piece, which must outlive
+  //               the list
+  //-----------------------------------------------
+  void add(const span& data);
+
+  //-----------------------------------------------
+  // Add a number in decimal to the end of
+  // the list
+  //
+  // @param number - The number to add
+  //-----------------------------------------------
+  void add(const unsigned number);
+
+  //-----------------------------------------------
+  // Add a version to the end of the list, such
+  // as "HTTP/1.1"
+  //
+  // @param version - The version to add
+  //-----------------------------------------------
+  void add(const Version& version);
+
+  //-----------------------------------------------
+  // Get the pieces, for <writev>
+  //
+  // There may be more than IOV_MAX pieces, which
+  // must then be written in batches
+  //-----------------------------------------------
+  const iovec* data() const noexcept { return entries_.begin(); }
+  size_t       size() const noexcept { return entries_.size(); }
+
+  //-----------------------------------------------
+  // Get the number of bytes in all the pieces
+  //
+  // @return - The number of bytes
+  //-----------------------------------------------
+  size_t bytes() const noexcept { return bytes_; }
+
+  //-----------------------------------------------
+  // Remove all pieces from the list
+  //-----------------------------------------------
+  void clear() noexcept;
+private:
+  Small_vector<iovec, Inline_entries> entries_;
+  size_t bytes_ {0};
+}; //< class Iovec_list
+
+/**--v----------- Implementation Details -----------v--**/
+
+///////////////////////////////////////////////////////////////////////////////
+inline void Iovec_list::add(const span& data) {
+  if (data.len == 0) return;
+  //-----------------------------------
+  bytes_ += data.len;
+  //-----------------------------------
+  if (not entries_.empty()) {
+    auto& last = entries_[entries_.size() - 1];
+    if (static_cast<const char*>(last.iov_base) + last.iov_len == data.data) {
+      last.iov_len += data.len;
+      return;
+    }
+  }
+  //-----------------------------------
+  entries_.push_back({const_cast<char*>(data.data), data.len});
+}
+
+///////////////////////////////////////////////////////////////////////////////
+inline void Iovec_list::add(const unsigned number) {
+  const auto text = Decimal_table<>::digits.text;
+  //-----------------------------------
+  if (number >= 1000) {
+    add(number / 1000);
+    add({text + (number % 1000) * 3, 3});
+    return;
+  }
+  //-----------------------------------
+  const size_t len = (number >= 100) ? 3 : (number >= 10) ? 2 : 1;
+  add({text + number * 3 + (3 - len), len});
+}
+
+///////////////////////////////////////////////////////////////////////////////
+inline void Iovec_list::add(const Version& version) {
+  static constexpr const char* known[] {"HTTP/1.0", "HTTP/1.1"};
+  //-----------------------------------
+  if (version.get_major() == 1 and version.get_minor() <= 1) {
+    add({known[version.get_minor()], 8});
+    return;
+  }
+  //-----------------------------------
+  add({"HTTP/", 5});
+  add(version.get_major());
+  add({".", 1});
+  add(version.get_minor());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+inline void Iovec_list::clear() noexcept {
+  entries_.clear();
+  bytes_ = 0;
+}
+
+/**--^----------- Implementation Details -----------^--**/
+
+} //< namespace http
+
+#endif //< HTTP_IOVEC_LIST_HPP
@@ -18,10 +18,12 @@
 #ifndef HTTP_MESSAGE_HPP
 #define HTTP_MESSAGE_HPP
 
-#include <sstream>
+#include <atomic>
+#include <thread>
 
 #include "time.hpp"
 #include "header.hpp"
+#include "iovec_list.hpp"
 #include "header_fields.hpp"
 
 namespace http {
@@ -33,7 +35,7 @@ private:
   //----------------------------------------
   using HSize        = Limit;
   using Message_Body = std::string;
-  using MBody_Length = std::string;
+  using Arena        = std::string;
   //----------------------------------------
 public:
   //----------------------------------------
@@ -51,9 +53,11 @@ public:
   explicit Message(const Limit limit) noexcept;
 
   //----------------------------------------
-  // Default copy constructor
+  // Copy constructor
+  //
+  // A deferred header block is indexed first
   //----------------------------------------
-  Message(const Message&) = default;
+  Message(const Message&);
 
   //----------------------------------------
   // Default move constructor
@@ -66,9 +70,11 @@ public:
   virtual ~Message() noexcept = default;
 
   //----------------------------------------
-  // Default copy assignment operator
+  // Copy assignment operator
+  //
+  // A deferred header block is indexed first
   //----------------------------------------
-  Message& operator = (const Message&) = default;
+  Message& operator = (const Message&);
 
   //----------------------------------------
   // Default move assignment operator
@@ -79,6 +85,10 @@ public:
   // Add a new field to the current set of
   // headers
   //
+  // The name and value are copied into the
+  // message unless they are within its buffers,
+  // so they can be built from temporaries
+  //
   // @param field - The field name
   // @param value - The field value
   //
@@ -109,6 +119,16 @@ public:
   //----------------------------------------
   bool has_header(const span& field) const noexcept;
 
+  //----------------------------------------
+  // Check if the specified well-known field
+  // is within this message
+  //
+  // @param field - The well-known field to search for
+  //
+  // @return - true is present, false otherwise
+  //----------------------------------------
+  bool has_header(const header::Field& field) const noexcept;
+
   //----------------------------------------
   // Get the value associated with the
   // specified field name
@@ -121,7 +141,82 @@ public:
   // @return - The value associated with the
   //           specified field name
   //----------------------------------------
-  const span& header_value(const span& field) const noexcept;
+  span header_value(const span& field) const noexcept;
+
+  //----------------------------------------
+  // Get the value associated with the
+  // specified well-known field
+  //
+  // Should call <has_header> before calling this
+  //
+  // @param field - The well-known field to get
+  //                associated value
+  //
+  // @return - The value associated with the
+  //           specified field
+  //----------------------------------------
+  span header_value(const header::Field& field) const noexcept;
+
+  //----------------------------------------
+  // Find the value associated with the
+  // specified field name
+  //
+  // Unlike <has_header> followed by <header_value>
+  // this searches the fields only once
+  //
+  // @param field - The field name to search for
+  //
+  // @return - The value associated with the
+  //           specified field name, without
+  //           data if not present
+  //----------------------------------------
+  span find_header_value(const span& field) const noexcept;
+
+  //----------------------------------------
+  // Find the value associated with the
+  // specified well-known field
+  //
+  // @param field - The well-known field to search for
+  //
+  // @return - The value associated with the
+  //           specified field, without data
+  //           if not present
+  //----------------------------------------
+  span find_header_value(const header::Field& field) const noexcept;
+
+  //----------------------------------------
+  // Get the values of every field with the
+  // specified name without copying them
+  //
+  // @param field - The field name to search for
+  //
+  // @return - A range over the values, empty
+  //           if not present
+  //----------------------------------------
+  Header::Value_range header_values(const span& field) const;
+
+  //----------------------------------------
+  // Get the values of every field with the
+  // specified well-known name without
+  // copying them
+  //
+  // @param field - The well-known field to search for
+  //
+  // @return - A range over the values, empty
+  //           if not present
+  //----------------------------------------
+  Header::Value_range header_values(const header::Field& field) const;
+
+  //----------------------------------------
+  // Get the fields of this message, which
+  // can be iterated as (name, value) spans
+  //
+  // The fields refer to the data of the message
+  // and are invalidated by any change to it
+  //
+  // @return - The fields of this message
+  //----------------------------------------
+  Header::Fields headers() const;
 
   //----------------------------------------
   // Check if there are no fields in this
@@ -160,6 +255,97 @@ public:
   //----------------------------------------
   Message& clear_headers() noexcept;
 
+  //----------------------------------------
+  // Defer indexing of the header fields of a
+  // parsed message until they are first accessed
+  //
+  // Messages that are dispatched without looking
+  // at their headers only pay for locating the
+  // header block
+  //
+  // The first access indexes the block, which
+  // is done once even when several threads
+  // read the message at the same time
+  //
+  // @param block - The header block, from the first
+  //                field name to the end of the
+  //                last field value
+  //
+  // @return - The object that invoked this method
+  //----------------------------------------
+  Message& set_header_block(const span& block) noexcept;
+
+  //----------------------------------------
+  // Record what the parser found out about
+  // the framing and connection of the message
+  //
+  // @param info - The framing and connection
+  //
+  // @return - The object that invoked this method
+  //----------------------------------------
+  Message& set_info(const Message_info& info) noexcept;
+
+  //----------------------------------------
+  // Get the framing and connection of the
+  // message
+  //
+  // The length follows the entity when it is
+  // changed with the methods of this class
+  //
+  // @return - The framing and connection
+  //----------------------------------------
+  const Message_info& info() const noexcept;
+
+  //----------------------------------------
+  // Get the length of the entity as given
+  // by the Content-Length field
+  //
+  // @return - The length, 0 if not known
+  //----------------------------------------
+  uint64_t content_length() const noexcept;
+
+  //----------------------------------------
+  // Check if the connection persists after
+  // this message
+  //
+  // @return - true if it persists, false otherwise
+  //----------------------------------------
+  bool keep_alive() const noexcept;
+
+  //----------------------------------------
+  // Check if the entity was sent in chunks
+  //
+  // @return - true if chunked, false otherwise
+  //----------------------------------------
+  bool is_chunked() const noexcept;
+
+  //----------------------------------------
+  // Check if the connection switches protocol
+  // after this message
+  //
+  // @return - true if upgraded, false otherwise
+  //----------------------------------------
+  bool is_upgrade() const noexcept;
+
+  //----------------------------------------
+  // Record where the value of the Host field
+  // is, so it can be read without a lookup
+  //
+  // @param host - The value of the Host field
+  //
+  // @return - The object that invoked this method
+  //----------------------------------------
+  Message& set_host(const span& host) noexcept;
+
+  //----------------------------------------
+  // Get the value of the Host field that was
+  // recorded by the parser
+  //
+  // @return - The value, without data if the
+  //           field was not received
+  //----------------------------------------
+  span host() const noexcept;
+
   //----------------------------------------
   // Add an entity to the message
   //
@@ -179,6 +365,62 @@ public:
   //----------------------------------------
   Message& add_chunk(const std::string& chunk);
 
+  //----------------------------------------
+  // Reserve room for an entity of the
+  // specified size
+  //
+  // Growing in steps keeps the cost of
+  // repeated calls linear
+  //
+  // @param size - The expected size of the entity
+  //
+  // @return - The object that invoked this method
+  //----------------------------------------
+  Message& reserve_body(const size_t size);
+
+  //----------------------------------------
+  // Append data to the entity of the message
+  // without updating the Content-Length field
+  //
+  // Call <complete_body> once the entity is
+  // complete
+  //
+  // @param data - The data to append to the entity
+  //
+  // @return - The object that invoked this method
+  //----------------------------------------
+  Message& append_body(const span& data);
+
+  //----------------------------------------
+  // Set the Content-Length field to the size
+  // of the entity
+  //
+  // @return - The object that invoked this method
+  //----------------------------------------
+  Message& complete_body();
+
+  //----------------------------------------
+  // Refer to an entity that is kept in a
+  // buffer outside of the message instead
+  // of copying it
+  //
+  // The buffer must outlive the message or
+  // the next change to the entity
+  //
+  // @param body - The entity
+  //
+  // @return - The object that invoked this method
+  //----------------------------------------
+  Message& set_body_view(const span& body) noexcept;
+
+  //----------------------------------------
+  // Get the entity in this message without
+  // copying it
+  //
+  // @return - The entity in this message
+  //----------------------------------------
+  span body_view() const noexcept;
+
   //----------------------------------------
   // Check if this message has an entity
   //
@@ -188,12 +430,23 @@ public:
   bool has_body() const noexcept;
 
   //----------------------------------------
-  // Get the entity in this the message if
-  // present
+  // Get a copy of the entity in this message
+  // if present
+  //
+  // Use <body_view> to read it without copying
   //
   // @return - The entity in this message
   //----------------------------------------
-  const Message_Body& get_body() const noexcept;
+  Message_Body get_body() const;
+
+  //----------------------------------------
+  // Copy an entity that is referred to with
+  // <set_body_view> into the message, so it no
+  // longer depends on the buffer
+  //
+  // @return - The object that invoked this method
+  //----------------------------------------
+  Message& own_body();
 
   //----------------------------------------
   // Remove the entity from the message
@@ -218,6 +471,40 @@ public:
   //-----------------------------------
   virtual std::string to_string() const;
 
+  //-----------------------------------
+  // Get the exact number of bytes in the
+  // string form of this message
+  //
+  // @return - The number of bytes
+  //-----------------------------------
+  virtual size_t serialized_size() const;
+
+  //-----------------------------------
+  // Write the string form of this message
+  // into a buffer
+  //
+  // @param buffer - The buffer to write into
+  // @param len    - The size of the buffer, at
+  //                 least <serialized_size>
+  //
+  // @return - The number of bytes written, 0 if
+  //           the message doesn't fit
+  //-----------------------------------
+  size_t serialize_into(char* buffer, const size_t len) const;
+
+  //-----------------------------------
+  // Describe this message as the pieces
+  // it is made of, so it can be written
+  // with <writev> without copying
+  //
+  // The pieces refer to the data of the
+  // message, which must not change until
+  // they are written
+  //
+  // @param list - The list to add the pieces to
+  //-----------------------------------
+  virtual void to_iovec(Iovec_list& list) const;
+
   //-----------------------------------
   // Operator to transform this class
   // into string form
@@ -225,15 +512,166 @@ public:
   operator std::string () const;
   //-----------------------------------
 
+protected:
+  //-----------------------------------
+  // Write the string form of this message
+  //
+  // @param writer - The writer to write with
+  //-----------------------------------
+  virtual void serialize(Buffer_writer& writer) const;
+
+  //-----------------------------------
+  // Get the buffer this message was parsed
+  // from, if it owns one
+  //
+  // Spans within it are stored as offsets
+  // so they follow the buffer when the
+  // message is copied or moved
+  //
+  // @return - The buffer, empty if none
+  //-----------------------------------
+  virtual span source() const noexcept;
+
 private:
+  //------------------------------
+  // Runs the indexing of a deferred
+  // header block once, when the first
+  // lookups come from several threads
+  // at the same time
+  //
+  // A copy is done only if the original
+  // was, the message indexes its block
+  // before it is copied
+  //------------------------------
+  class Index_once {
+  public:
+    Index_once() = default;
+
+    Index_once(const Index_once& other) noexcept
+      : state_{other.done() ? Done : Pending}
+    {}
+
+    Index_once& operator = (const Index_once& other) noexcept {
+      state_.store(other.done() ? Done : Pending, std::memory_order_relaxed);
+      return *this;
+    }
+
+    bool done() const noexcept
+    { return state_.load(std::memory_order_acquire) == Done; }
+
+    //------------------------------
+    // Run <task> unless it was run, the
+    // threads that lose the race wait
+    // for the one running it
+    //------------------------------
+    template <typename Task>
+    void operator()(Task&& task) const;
+
+    //------------------------------
+    // Make the next call run again
+    //------------------------------
+    void reset() noexcept
+    { state_.store(Pending, std::memory_order_relaxed); }
+  private:
+    enum State : uint8_t { Pending, Running, Done };
+
+    mutable std::atomic<uint8_t> state_ {Pending};
+  }; //< class Index_once
+
   //------------------------------
   // Class data members
   //------------------------------
-  Header       header_fields_;
-  Message_Body message_body_;
-  MBody_Length mbody_length_;
+  mutable Header       header_fields_;
+  Offset_span          header_block_;
+  Index_once           indexed_;
+  Message_Body         message_body_;
+  Offset_span          body_view_;
+  Arena                arena_;
+  Message_info         info_;
+  Offset_span          host_;
+
+  //------------------------------
+  // Get the current location of the
+  // buffers the spans of this message
+  // are stored relative to
+  //------------------------------
+  Span_bases bases() const noexcept;
+
+  //------------------------------
+  // Get the fields, indexed
+  //
+  // They are relative to the buffers
+  // of the message, so <bases> must be
+  // passed to the methods that convert
+  // spans
+  //------------------------------
+  const Header& header_fields() const;
+  Header&       header_fields();
+
+  //------------------------------
+  // Index the fields of a deferred
+  // header block
+  //
+  // Only called through <indexed_>, the
+  // fields are not written otherwise by
+  // const methods
+  //------------------------------
+  void index_headers() const;
+
+  //------------------------------
+  // Copy data that is not within the
+  // buffers of the message to the end
+  // of the arena
+  //
+  // The arena is a single block that
+  // grows with the message and is only
+  // rewound by <clear_headers>, so the
+  // spans are kept relative to it
+  //
+  // @param data - The data to copy
+  //
+  // @return - The data relative to the
+  //           buffers that contain it
+  //------------------------------
+  Offset_span store(const span& data);
+
+  //------------------------------
+  // Set the Content-Length field to
+  // the specified size and record it
+  // in the info
+  //------------------------------
+  Message& set_content_length(const size_t size);
 }; //< class Message
 
+/**--v----------- Implementation Details -----------v--**/
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename Task>
+inline void Message::Index_once::operator()(Task&& task) const {
+  for (;;) {
+    auto state = state_.load(std::memory_order_acquire);
+    //-----------------------------------
+    if (state == Done) return;
+    //-----------------------------------
+    if (state == Pending
+        and state_.compare_exchange_weak(state, Running, std::memory_order_acquire))
+    {
+      try {
+        task();
+      } catch (...) {
+        state_.store(Pending, std::memory_order_release);
+        throw;
+      }
+      state_.store(Done, std::memory_order_release);
+      return;
+    }
+    //-----------------------------------
+    std::this_thread::yield();
+  }
+}
+
+/**--^----------- Implementation Details -----------^--**/
+
 } //< namespace http
 
 #endif //< HTTP_MESSAGE_HPP
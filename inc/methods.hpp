@@ -18,35 +18,85 @@
 #ifndef HTTP_METHODS_HPP
 #define HTTP_METHODS_HPP
 
-#include <array>
 #include <string>
+#include <cstddef>
 #include <ostream>
 
 namespace http {
 
   enum Method {
     GET, POST, PUT, DELETE, OPTIONS, HEAD, TRACE, CONNECT, PATCH,
+    //< WebDAV
+    COPY, LOCK, MKCOL, MOVE, PROPFIND, PROPPATCH, SEARCH, UNLOCK,
+    BIND, REBIND, UNBIND, ACL,
+    //< Subversion
+    REPORT, MKACTIVITY, CHECKOUT, MERGE,
+    //< UPnP
+    MSEARCH, NOTIFY, SUBSCRIBE, UNSUBSCRIBE,
+    //< Caching, CalDAV and RFC-2068
+    PURGE, MKCALENDAR, LINK, UNLINK,
     INVALID = 0xffff
   };
 
   namespace method {
 
-    /** Get method string from method code **/
-    inline const std::string& str(const Method m) {
-
-      static std::array<std::string, 10> strings
-      {
-        {
-         "GET", "POST", "PUT", "DELETE", "OPTIONS",
-         "HEAD", "TRACE", "CONNECT", "PATCH", "INVALID"
-        }
+    /**
+     * Lookup tables for the methods
+     *
+     * <strings> is indexed by <Method> while <parser_codes> is indexed
+     * by the <http_method> code of the underlying parser, see
+     * HTTP_METHOD_MAP in http_parser.h
+     **/
+    template <typename = void>
+    struct Tables {
+      static constexpr const char* strings[] {
+        "GET", "POST", "PUT", "DELETE", "OPTIONS",
+        "HEAD", "TRACE", "CONNECT", "PATCH",
+        "COPY", "LOCK", "MKCOL", "MOVE", "PROPFIND", "PROPPATCH", "SEARCH", "UNLOCK",
+        "BIND", "REBIND", "UNBIND", "ACL",
+        "REPORT", "MKACTIVITY", "CHECKOUT", "MERGE",
+        "M-SEARCH", "NOTIFY", "SUBSCRIBE", "UNSUBSCRIBE",
+        "PURGE", "MKCALENDAR", "LINK", "UNLINK",
+        "INVALID"
       };
 
-      if ((m >= 0) and (m < (strings.size() - 1))) {
-        return strings[m];
-      }
+      static constexpr Method parser_codes[] {
+        DELETE, GET, HEAD, POST, PUT, CONNECT, OPTIONS, TRACE,
+        COPY, LOCK, MKCOL, MOVE, PROPFIND, PROPPATCH, SEARCH, UNLOCK,
+        BIND, REBIND, UNBIND, ACL,
+        REPORT, MKACTIVITY, CHECKOUT, MERGE,
+        MSEARCH, NOTIFY, SUBSCRIBE, UNSUBSCRIBE,
+        PATCH, PURGE, MKCALENDAR, LINK, UNLINK
+      };
+
+      static constexpr std::size_t count {sizeof(strings) / sizeof(strings[0]) - 1};
+    };
+
+    template <typename T>
+    constexpr const char* Tables<T>::strings[];
 
-      return strings[strings.size() - 1];
+    template <typename T>
+    constexpr Method Tables<T>::parser_codes[];
+
+    /** Get method string from method code **/
+    constexpr const char* str(const Method m) noexcept {
+      return (static_cast<std::size_t>(m) < Tables<>::count)
+             ? Tables<>::strings[m]
+             : Tables<>::strings[Tables<>::count];
+    }
+
+    /**
+     * Get a code mapping from the method code
+     * of the underlying parser
+     *
+     * @param method - The <http_method> code
+     *
+     * @return - The code mapped to the method
+     **/
+    constexpr Method from_parser(const unsigned method) noexcept {
+      return (method < (sizeof(Tables<>::parser_codes) / sizeof(Tables<>::parser_codes[0])))
+             ? Tables<>::parser_codes[method]
+             : INVALID;
     }
 
     /**
@@ -58,16 +108,9 @@ namespace http {
      * @return - The code mapped to the method
      **/
     inline Method code(const std::string& method) noexcept {
-
-      if (method == str(GET))     return GET;
-      if (method == str(POST))    return POST;
-      if (method == str(PUT))     return PUT;
-      if (method == str(DELETE))  return DELETE;
-      if (method == str(OPTIONS)) return OPTIONS;
-      if (method == str(HEAD))    return HEAD;
-      if (method == str(TRACE))   return TRACE;
-      if (method == str(CONNECT)) return CONNECT;
-      if (method == str(PATCH))   return PATCH;
+      for (std::size_t i = 0; i < Tables<>::count; ++i) {
+        if (method == Tables<>::strings[i]) return static_cast<Method>(i);
+      }
 
       return INVALID;
     }
@@ -0,0 +1,227 @@
+// This file is a part of the IncludeOS unikernel - www.includeos.org
+//
+// Copyright 2015-2016 Oslo and Akershus University College of Applied Sciences
+// and Alfred Bratterud
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef HTTP_NEGOTIATION_HPP
+#define HTTP_NEGOTIATION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+#include "span.hpp"
+
+namespace http {
+
+//-----------------------------------------------
+// The kind of value that is negotiated, which
+// decides how ranges such as "text/*" match
+//-----------------------------------------------
+enum class Negotiation {
+  Media_type, //< Accept
+  Charset,    //< Accept-Charset
+  Encoding,   //< Accept-Encoding
+  Language    //< Accept-Language
+};
+
+//-----------------------------------------------
+// This class is used to parse the value of an
+// Accept field into (token, q) pairs, sorted by
+// preference
+//
+// The pairs refer to the value and are kept
+// within the object, so parsing doesn't allocate
+//-----------------------------------------------
+class Preferences {
+public:
+  //-----------------------------------------------
+  // At most this many pairs are kept, the least
+  // preferred are dropped beyond it
+  //-----------------------------------------------
+  static constexpr size_t Capacity {32};
+
+  //-----------------------------------------------
+  // A token with its quality in thousandths,
+  // so "q=0.8" is 800
+  //-----------------------------------------------
+  struct Preference {
+    span     token;
+    uint16_t q;
+  };
+
+  //-----------------------------------------------
+  // Constructor
+  //
+  // @param value - The value of the field
+  //-----------------------------------------------
+  explicit Preferences(const span& value) noexcept;
+
+  //-----------------------------------------------
+  // Iterate over the pairs from the most
+  // preferred, pairs of equal quality are kept
+  // in the order they were received
+  //-----------------------------------------------
+  const Preference* begin() const noexcept { return prefs_; }
+  const Preference* end()   const noexcept { return prefs_ + size_; }
+
+  size_t size()  const noexcept { return size_; }
+  bool   empty() const noexcept { return size_ == 0; }
+private:
+  Preference prefs_[Capacity];
+  size_t     size_ {0};
+
+  //-----------------------------------------------
+  // Insert a pair after those that are at
+  // least as preferred
+  //-----------------------------------------------
+  void insert(const Preference& pref) noexcept;
+}; //< class Preferences
+
+//-----------------------------------------------
+// This class is used to choose the best of a set
+// of offers for the value of an Accept field
+//
+// The offers are compiled once, so choosing
+// costs a single pass over the value. The result
+// for a value is cached since clients send the
+// same value with every request
+//
+// The cache is kept for each thread and shared
+// by the negotiators, so a negotiator can be
+// shared between threads
+//-----------------------------------------------
+class Negotiator {
+public:
+  //-----------------------------------------------
+  // At most this many offers are kept, so the
+  // acceptable offers fit in a bitmask
+  //-----------------------------------------------
+  static constexpr size_t Max_offers {32};
+
+  //-----------------------------------------------
+  // Returned when no offer is acceptable
+  //-----------------------------------------------
+  static constexpr size_t npos {static_cast<size_t>(-1)};
+
+  //-----------------------------------------------
+  // Constructor
+  //
+  // The offers must outlive the negotiator, such
+  // as string literals, and are preferred in the
+  // order they are given when the client has no
+  // preference between them
+  //
+  // @param kind   - The kind of value negotiated
+  // @param offers - The values the server can produce,
+  //                 such as "application/json"
+  //-----------------------------------------------
+  explicit Negotiator(const Negotiation kind, std::initializer_list<span> offers) noexcept;
+
+  //-----------------------------------------------
+  // Choose the best offer
+  //
+  // A field that is absent, a value without data,
+  // accepts every offer
+  //
+  // @param value - The value of the field
+  //
+  // @return - Index of the best offer, or <npos>
+  //           if none is acceptable
+  //-----------------------------------------------
+  size_t select(const span& value) const noexcept;
+
+  //-----------------------------------------------
+  // Choose the best offer
+  //
+  // @param value - The value of the field
+  //
+  // @return - The best offer, without data if
+  //           none is acceptable
+  //-----------------------------------------------
+  span best(const span& value) const noexcept;
+
+  //-----------------------------------------------
+  // Get every offer the client accepts
+  //
+  // @param value - The value of the field
+  //
+  // @return - Bit i is set if offer i is acceptable
+  //-----------------------------------------------
+  uint32_t acceptable(const span& value) const noexcept;
+
+  //-----------------------------------------------
+  // Get an offer
+  //
+  // @param index - Index of the offer
+  //
+  // @return - The offer
+  //-----------------------------------------------
+  span offer(const size_t index) const noexcept;
+
+  //-----------------------------------------------
+  // Get the number of offers
+  //
+  // @return - The number of offers
+  //-----------------------------------------------
+  size_t size() const noexcept;
+private:
+  //-----------------------------------------------
+  // Values up to this length are cached, which
+  // covers what browsers send
+  //-----------------------------------------------
+  static constexpr size_t Cache_slots {32};
+  static constexpr size_t Max_cached  {192};
+
+  struct Offer {
+    span     token;
+    uint32_t hash; //< Exact matches are compared by hash first
+    uint16_t type; //< Length of the type of a media type
+  };
+
+  struct Cache_entry {
+    uint32_t owner {0}; //< The negotiator the entry is for, 0 if unused
+    uint32_t hash;
+    uint16_t len;
+    uint8_t  result;
+    char     value[Max_cached];
+  };
+
+  Negotiation kind_;
+  Offer       offers_[Max_offers];
+  size_t      size_ {0};
+
+  //-----------------------------------------------
+  // Identifies the negotiator in the cache, copies
+  // share it since they have the same offers
+  //-----------------------------------------------
+  uint32_t id_;
+
+  //-----------------------------------------------
+  // Get the entry of the cache of the calling
+  // thread for a value
+  //-----------------------------------------------
+  Cache_entry& cache_entry(const uint32_t hash) const noexcept;
+
+  //-----------------------------------------------
+  // Get the quality of each offer for the
+  // parsed value
+  //-----------------------------------------------
+  void qualities(const Preferences& prefs, uint16_t (&q)[Max_offers]) const noexcept;
+}; //< class Negotiator
+
+} //< namespace http
+
+#endif //< HTTP_NEGOTIATION_HPP
@@ -0,0 +1,197 @@
+// This file is a part of the IncludeOS unikernel - www.includeos.org
+//
+// Copyright 2015-2016 Oslo and Akershus University College of Applied Sciences
+// and Alfred Bratterud
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef HTTP_OFFSET_SPAN_HPP
+#define HTTP_OFFSET_SPAN_HPP
+
+#include <cstdint>
+
+#include "span.hpp"
+
+namespace http {
+
+//-----------------------------------------------
+// This is a span that is stored as an offset into
+// the buffer it refers to
+//
+// A message copies or moves its buffers along with
+// itself, so a span that was relative to the old
+// buffers is valid for the new ones as well
+//-----------------------------------------------
+struct Offset_span {
+  //-----------------------------------------------
+  // The buffer the offset is relative to
+  //-----------------------------------------------
+  enum Base : uint8_t {
+    Absolute, //< Not within a buffer of the message
+    Source,   //< The buffer the message was parsed from
+    Owned     //< The data owned by the message itself
+  };
+
+  uintptr_t offset {0};
+  size_t    len    {0};
+  Base      base   {Absolute};
+}; //< struct Offset_span
+
+//-----------------------------------------------
+// This is an offset span packed into 64 bits for
+// tables that hold many of them
+//
+// The offset and length of a span that doesn't
+// fit, or that isn't within a buffer, must be
+// kept elsewhere and the offset used as its index
+//-----------------------------------------------
+class Compact_span {
+public:
+  //-----------------------------------------------
+  // The buffer the offset is relative to, the
+  // values match those of <Offset_span::Base>
+  //-----------------------------------------------
+  enum Base : uint32_t {
+    External = Offset_span::Absolute, //< The offset is an index of a span kept elsewhere
+    Source   = Offset_span::Source,
+    Owned    = Offset_span::Owned
+  };
+
+  static constexpr uint32_t Max_offset {(1U << 30) - 1};
+  static constexpr uint32_t Max_len    {UINT32_MAX};
+
+  //-----------------------------------------------
+  // Constructor to create an empty span
+  //-----------------------------------------------
+  constexpr Compact_span() noexcept
+    : position_{0}
+    , len_{0}
+  {}
+
+  //-----------------------------------------------
+  // Constructor
+  //
+  // @param base   - The buffer the offset is relative to
+  // @param offset - The offset, at most <Max_offset>
+  // @param len    - The length
+  //-----------------------------------------------
+  constexpr Compact_span(const Base base, const uint32_t offset, const uint32_t len) noexcept
+    : position_{(static_cast<uint32_t>(base) << 30) | offset}
+    , len_{len}
+  {}
+
+  constexpr Base     base()   const noexcept { return static_cast<Base>(position_ >> 30); }
+  constexpr uint32_t offset() const noexcept { return position_ & Max_offset; }
+  constexpr uint32_t len()    const noexcept { return len_; }
+private:
+  uint32_t position_; //< The base in the top two bits
+  uint32_t len_;
+}; //< class Compact_span
+
+static_assert(sizeof(Compact_span) == 8, "Compact_span is expected to be packed into 64 bits");
+
+//-----------------------------------------------
+// This class is used to convert between spans
+// and offset spans for the current location of
+// the buffers of a message
+//-----------------------------------------------
+class Span_bases {
+public:
+  //-----------------------------------------------
+  // Constructor for a message without buffers
+  //-----------------------------------------------
+  Span_bases() noexcept = default;
+
+  //-----------------------------------------------
+  // Constructor
+  //
+  // @param source - The buffer the message was parsed from
+  // @param owned  - The data owned by the message itself
+  //-----------------------------------------------
+  Span_bases(const span& source, const span& owned) noexcept;
+
+  //-----------------------------------------------
+  // Convert a span into an offset span, relative
+  // to the buffer that contains it
+  //
+  // @param s - The span to convert
+  //
+  // @return - The offset span
+  //-----------------------------------------------
+  Offset_span to_offset(const span& s) const noexcept;
+
+  //-----------------------------------------------
+  // Convert an offset span into a span
+  //
+  // @param o - The offset span to convert
+  //
+  // @return - The span, without data if the offset
+  //           span was made from an empty span
+  //-----------------------------------------------
+  span to_span(const Offset_span& o) const noexcept;
+private:
+  span source_;
+  span owned_;
+
+  static bool contains(const span& buffer, const span& s) noexcept;
+}; //< class Span_bases
+
+/**--v----------- Implementation Details -----------v--**/
+
+///////////////////////////////////////////////////////////////////////////////
+inline Span_bases::Span_bases(const span& source, const span& owned) noexcept
+  : source_{source}
+  , owned_{owned}
+{}
+
+///////////////////////////////////////////////////////////////////////////////
+inline bool Span_bases::contains(const span& buffer, const span& s) noexcept {
+  const auto begin = reinterpret_cast<uintptr_t>(buffer.data);
+  const auto at    = reinterpret_cast<uintptr_t>(s.data);
+  //-----------------------------------
+  return buffer.data not_eq nullptr
+         and at >= begin
+         and at + s.len <= begin + buffer.len;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+inline Offset_span Span_bases::to_offset(const span& s) const noexcept {
+  if (contains(source_, s)) {
+    return {static_cast<uintptr_t>(s.data - source_.data), s.len, Offset_span::Source};
+  }
+  //-----------------------------------
+  if (contains(owned_, s)) {
+    return {static_cast<uintptr_t>(s.data - owned_.data), s.len, Offset_span::Owned};
+  }
+  //-----------------------------------
+  return {reinterpret_cast<uintptr_t>(s.data), s.len, Offset_span::Absolute};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+inline span Span_bases::to_span(const Offset_span& o) const noexcept {
+  switch (o.base) {
+    case Offset_span::Source:
+      return {source_.data + o.offset, o.len};
+    case Offset_span::Owned:
+      return {owned_.data + o.offset, o.len};
+    default:
+      return {reinterpret_cast<const char*>(o.offset), o.len};
+  }
+}
+
+/**--^----------- Implementation Details -----------^--**/
+
+} //< namespace http
+
+#endif //< HTTP_OFFSET_SPAN_HPP
@@ -49,8 +49,30 @@ public:
   //
   // @param limit - Capacity of how many fields can
   //                be added
+  //
+  // @param options - How the request is parsed
+  //----------------------------------------
+  explicit Request(std::string request, const Limit limit = 100,
+                   const Parse_options options = Parse_default);
+
+  //----------------------------------------
+  // Constructor to construct a request
+  // message in place from a receive buffer
+  //
+  // The buffer is adopted by the message and
+  // its parts refer directly into it so no
+  // copy of the data is made
+  //
+  // @param buf   - The buffer holding the data
+  // @param len   - The length of the data in the buffer
+  //
+  // @param limit - Capacity of how many fields can
+  //                be added
+  //
+  // @param options - How the request is parsed
   //----------------------------------------
-  explicit Request(std::string request, const Limit limit = 100);
+  explicit Request(buffer_t buf, const size_t len, const Limit limit = 100,
+                   const Parse_options options = Parse_default);
 
   //----------------------------------------
   // Default copy constructor
@@ -163,12 +185,20 @@ public:
   virtual Request& reset() noexcept override;
 
   //----------------------------------------
-  // Get a string representation of this
-  // class
+  // Get the exact number of bytes in the
+  // string form of this request
+  //
+  // @return - The number of bytes
+  //----------------------------------------
+  virtual size_t serialized_size() const override;
+
+  //----------------------------------------
+  // Describe this request as the pieces
+  // it is made of
   //
-  // @return - A string representation
+  // @param list - The list to add the pieces to
   //----------------------------------------
-  virtual std::string to_string() const override;
+  virtual void to_iovec(Iovec_list& list) const override;
 
   //----------------------------------------
   // Operator to transform this class
@@ -178,12 +208,29 @@ public:
   //----------------------------------------
 
   span& field() noexcept;
+
+protected:
+  //----------------------------------------
+  // Write the string form of this request
+  //
+  // @param writer - The writer to write with
+  //----------------------------------------
+  virtual void serialize(Buffer_writer& writer) const override;
+
+  //----------------------------------------
+  // Get the buffer this request was parsed
+  // from, if it owns one
+  //----------------------------------------
+  virtual span source() const noexcept override;
+
 private:
   //----------------------------------------
   // Class data members
   //----------------------------------------
-  const std::string request_;
-  span              field_;
+  std::string request_;
+  buffer_t    buffer_;
+  size_t      buffer_len_ {0};
+  span        field_;
 
   //----------------------------------------
   // Request-line parts
@@ -207,8 +254,51 @@ private:
   //----------------------------------------
   template <typename Data, typename Name>
   std::string get_value(Data&& data, Name&& name) const noexcept;
+
+  //----------------------------------------
+  // Constructor used by <Request_parser> to
+  // build a request message incrementally
+  //
+  // @param limit - Capacity of how many fields can
+  //                be added
+  //----------------------------------------
+  explicit Request(const Limit limit) noexcept;
+
+  friend class Request_parser;
+
+  friend Request_list make_requests(buffer_t, const size_t, size_t&, const Limit, const Parse_options);
 }; //< class Request
 
+/**--v----------- Helper Functions -----------v--**/
+
+//----------------------------------------
+// Extract every complete request message
+// from a receive buffer holding pipelined
+// requests
+//
+// All the requests adopt the same buffer
+// and are parsed in place
+//
+// @param buf   - The buffer holding the data
+// @param len   - The length of the data in the buffer
+// @param tail  - Set to the offset of the first byte
+//                not consumed, where an incomplete or
+//                malformed request starts, which is
+//                left as it was received apart from
+//                folded field values, joined in a way
+//                that parses the same
+// @param limit - Capacity of how many fields can
+//                be added to each request
+// @param options - How the requests are parsed
+//
+// @return - The complete requests in the order
+//           they were received
+//----------------------------------------
+Request_list make_requests(buffer_t buf, const size_t len, size_t& tail, const Limit limit = 100,
+                           const Parse_options options = Parse_default);
+
+/**--^----------- Helper Functions -----------^--**/
+
 /**--v----------- Implementation Details -----------v--**/
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -245,13 +335,13 @@ inline std::string Request::get_value(Data&& data, Name&& name) const noexcept {
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-inline Request_ptr make_request(std::string request) {
-  return std::make_shared<Request>(std::move(request));
+inline Request_ptr make_request(std::string request, const Parse_options options = Parse_default) {
+  return std::make_shared<Request>(std::move(request), 100, options);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-inline Request_ptr make_request(buffer_t buf, const size_t len) {
-  return make_request(std::string{reinterpret_cast<char*>(buf.get()), len});
+inline Request_ptr make_request(buffer_t buf, const size_t len, const Parse_options options = Parse_default) {
+  return std::make_shared<Request>(std::move(buf), len, 100, options);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,259 @@
+// This file is a part of the IncludeOS unikernel - www.includeos.org
+//
+// Copyright 2015-2016 Oslo and Akershus University College of Applied Sciences
+// and Alfred Bratterud
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef HTTP_REQUEST_PARSER_HPP
+#define HTTP_REQUEST_PARSER_HPP
+
+#include "request.hpp"
+#include "basic_parser.hpp"
+
+namespace http {
+
+//----------------------------------------
+// This class is used to parse an http
+// request message that arrives in
+// fragments, as it does from a socket
+//
+// The parser state is kept between calls
+// to <feed> so every byte is scanned
+// exactly once, no matter how the message
+// was fragmented
+//----------------------------------------
+class Request_parser : private Parser_handler {
+public:
+  //----------------------------------------
+  // The progress of the message being parsed
+  //----------------------------------------
+  enum class Status {
+    Need_more,
+    Headers_complete,
+    Message_complete,
+    Error
+  };
+
+  //----------------------------------------
+  // Constructor
+  //
+  // @param limit   - Capacity of how many fields can
+  //                  be added to each request
+  // @param options - How the requests are parsed, the
+  //                  body is always copied since its
+  //                  fragments are owned by the caller
+  //----------------------------------------
+  explicit Request_parser(const Limit limit = 100,
+                          const Parse_options options = Parse_default);
+
+  //----------------------------------------
+  // Default destructor
+  //----------------------------------------
+  ~Request_parser() noexcept = default;
+
+  //----------------------------------------
+  // The parser refers to itself through the
+  // underlying <http_parser> so it can't be
+  // copied or moved
+  //----------------------------------------
+  Request_parser(const Request_parser&) = delete;
+  Request_parser(Request_parser&&) = delete;
+  Request_parser& operator = (const Request_parser&) = delete;
+  Request_parser& operator = (Request_parser&&) = delete;
+
+  //----------------------------------------
+  // Feed the next fragment of the character
+  // stream of data to the parser
+  //
+  // Parsing stops at the end of a message, so
+  // the bytes that follow it are left unconsumed
+  // and must be fed again after the completed
+  // request has been taken with <release>
+  //
+  // @param data - The fragment of data
+  // @param len  - The length of the fragment
+  //
+  // @return - The progress of the message
+  //----------------------------------------
+  Status feed(const char* data, const size_t len);
+
+  //----------------------------------------
+  // Get the progress of the message
+  //
+  // @return - The progress of the message
+  //----------------------------------------
+  Status status() const noexcept;
+
+  //----------------------------------------
+  // Get the number of bytes consumed from the
+  // fragment given in the last call to <feed>
+  //
+  // @return - The number of bytes consumed
+  //----------------------------------------
+  size_t consumed() const noexcept;
+
+  //----------------------------------------
+  // Get the error reported by the underlying
+  // parser
+  //
+  // @return - The error, HPE_OK if none
+  //----------------------------------------
+  http_errno error() const noexcept;
+
+  //----------------------------------------
+  // Get the request message being parsed
+  //
+  // Headers are available once the status is
+  // <Status::Headers_complete> and the body
+  // once it is <Status::Message_complete>
+  //
+  // @return - The request, nullptr if nothing
+  //           has been parsed yet
+  //----------------------------------------
+  Request_ptr request() const noexcept;
+
+  //----------------------------------------
+  // Take the completed request message and
+  // prepare the parser for the next message
+  // on the same connection
+  //
+  // @return - The completed request, nullptr
+  //           if the message is not complete
+  //----------------------------------------
+  Request_ptr release();
+
+  //----------------------------------------
+  // Reset the parser as if it was now
+  // default constructed
+  //----------------------------------------
+  void reset();
+private:
+  //----------------------------------------
+  // A token within <buffer_> that may be
+  // received in several fragments
+  //----------------------------------------
+  struct Token {
+    size_t offset;
+    size_t length;
+  };
+
+  enum class Last { None, Field, Value };
+
+  //----------------------------------------
+  // Class data members
+  //----------------------------------------
+  http_parser   parser_;
+  Limit         limit_;
+  Parse_options options_;
+  Status        status_;
+  size_t        consumed_;
+
+  //----------------------------------------
+  // The request-line and header block, the
+  // body is appended to the request directly
+  //----------------------------------------
+  std::string buffer_;
+  Request_ptr request_;
+
+  //----------------------------------------
+  // Partially received tokens
+  //----------------------------------------
+  Token                                url_;
+  Token                                field_;
+  Token                                value_;
+  Last                                 last_;
+  std::vector<std::pair<Token, Token>> fields_;
+  std::vector<Token>                   body_;
+
+  //----------------------------------------
+  // The number of <fields_> received before
+  // the body, the rest are trailers, and the
+  // end of the header block in <buffer_>
+  //----------------------------------------
+  size_t header_count_;
+  size_t header_end_;
+
+  //----------------------------------------
+  // A trailer that is received after the
+  // header block was handed over
+  //----------------------------------------
+  std::string trailer_field_;
+  std::string trailer_value_;
+
+  //----------------------------------------
+  // The data being parsed, and whether the
+  // last piece of a value was cut off by its
+  // end rather than by a line break, which
+  // tells a folded line from the rest of it
+  //----------------------------------------
+  const char* input_begin_ {nullptr};
+  const char* input_end_   {nullptr};
+  bool        value_cut_   {false};
+  bool        unfolding_   {false};
+
+  //----------------------------------------
+  // Prepare the per-message state
+  //----------------------------------------
+  void prepare();
+
+  //----------------------------------------
+  // Run the underlying parser over the
+  // specified data
+  //
+  // @return - The number of bytes consumed
+  //----------------------------------------
+  size_t execute(const char* data, const size_t len) noexcept;
+
+  //----------------------------------------
+  // Hand the header block over to the request
+  // and register the received tokens with it
+  //----------------------------------------
+  void materialize();
+
+  //----------------------------------------
+  // Drop the body received with the header
+  // block from <buffer_> once it is copied,
+  // moving the trailers after it in its place
+  //----------------------------------------
+  void trim_body();
+
+  //----------------------------------------
+  // Set the Content-Length field of the
+  // completed request if it didn't have one
+  //----------------------------------------
+  void complete_body();
+
+  //----------------------------------------
+  // Register the field whose value was
+  // received last
+  //----------------------------------------
+  void flush_field();
+
+  //----------------------------------------
+  // Events of the underlying parser
+  //----------------------------------------
+  int on_message_begin(http_parser&);
+  int on_url(http_parser&, const char* at, size_t length) noexcept;
+  int on_header_field(http_parser&, const char* at, size_t length);
+  int on_header_value(http_parser&, const char* at, size_t length);
+  int on_headers_complete(http_parser& parser);
+  int on_body(http_parser& parser, const char* at, size_t length);
+  int on_message_complete(http_parser& parser);
+
+  friend class Basic_parser<Request_parser>;
+}; //< class Request_parser
+
+} //< namespace http
+
+#endif //< HTTP_REQUEST_PARSER_HPP
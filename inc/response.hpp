@@ -18,6 +18,7 @@
 #ifndef HTTP_RESPONSE_HPP
 #define HTTP_RESPONSE_HPP
 
+#include "time.hpp"
 #include "message.hpp"
 #include "version.hpp"
 #include "status_codes.hpp"
@@ -54,6 +55,22 @@ public:
   //----------------------------------------
   explicit Response(std::string response, const Limit limit = 100);
 
+  //----------------------------------------
+  // Constructor to construct a response
+  // message in place from a receive buffer
+  //
+  // The buffer is adopted by the message and
+  // its parts refer directly into it so no
+  // copy of the data is made
+  //
+  // @param buf   - The buffer holding the data
+  // @param len   - The length of the data in the buffer
+  //
+  // @param limit - Capacity of how many fields can
+  //                be added
+  //----------------------------------------
+  explicit Response(buffer_t buf, const size_t len, const Limit limit = 100);
+
   //----------------------------------------
   // Default copy constructor
   //----------------------------------------
@@ -116,6 +133,25 @@ public:
   //----------------------------------------
   Response& set_version(const Version version) noexcept;
 
+  //----------------------------------------
+  // Stamp the response with a Date field for
+  // the current time
+  //
+  // The text of <time::date> is copied into the
+  // response instead of being stored among its
+  // fields, so the pieces of <to_iovec> only
+  // refer to the response. Stamp it again to
+  // bring the time up to date
+  //
+  // A Date field that was added to the message
+  // takes precedence, since there can only be one
+  //
+  // @param stamp - Whether to stamp the response
+  //
+  // @return - The object that invoked this method
+  //----------------------------------------
+  Response& stamp_date(const bool stamp = true) noexcept;
+
   //----------------------------------------
   // Reset the response message as if it was now
   // default constructed
@@ -125,12 +161,20 @@ public:
   virtual Response& reset() noexcept override;
   
   //-----------------------------------
-  // Get a string representation of this
-  // class
+  // Get the exact number of bytes in the
+  // string form of this response
   //
-  // @return - A string representation
+  // @return - The number of bytes
   //-----------------------------------
-  virtual std::string to_string() const override;
+  virtual size_t serialized_size() const override;
+
+  //-----------------------------------
+  // Describe this response as the pieces
+  // it is made of
+  //
+  // @param list - The list to add the pieces to
+  //-----------------------------------
+  virtual void to_iovec(Iovec_list& list) const override;
 
   //-----------------------------------
   // Operator to transform this class
@@ -142,12 +186,28 @@ public:
   span& field() noexcept {
     return field_;
   }
-  
+
+protected:
+  //----------------------------------------
+  // Write the string form of this response
+  //
+  // @param writer - The writer to write with
+  //----------------------------------------
+  virtual void serialize(Buffer_writer& writer) const override;
+
+  //----------------------------------------
+  // Get the buffer this response was parsed
+  // from, if it owns one
+  //----------------------------------------
+  virtual span source() const noexcept override;
+
 private:
   //------------------------------
   // Class data members
   //------------------------------
   const std::string response_;
+  const buffer_t    buffer_;
+  const size_t      buffer_len_ {0};
   span              field_;
 
   //----------------------------------------
@@ -155,6 +215,23 @@ private:
   //----------------------------------------
   Code    code_;
   Version version_;
+
+  //----------------------------------------
+  // The Date field the response is stamped
+  // with, stamped if the length isn't 0
+  //----------------------------------------
+  char   date_[time::Date_len] {};
+  size_t date_len_ {0};
+
+  //----------------------------------------
+  // Get the Date field the response is
+  // stamped with
+  //
+  // @return - The current time, without data
+  //           if not stamped or the message has
+  //           a Date field
+  //----------------------------------------
+  span date() const noexcept;
 }; //< class Response
 
 /**--v----------- Helper Functions -----------v--**/
@@ -175,7 +252,7 @@ inline Response_ptr make_response(std::string response) {
 
 ///////////////////////////////////////////////////////////////////////////////
 inline Response_ptr make_response(buffer_t buf, const size_t len) {
-  return make_response(std::string{reinterpret_cast<char*>(buf.get()), len});
+  return std::make_shared<Response>(std::move(buf), len);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
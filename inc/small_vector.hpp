@@ -0,0 +1,314 @@
+// This file is a part of the IncludeOS unikernel - www.includeos.org
+//
+// Copyright 2015-2016 Oslo and Akershus University College of Applied Sciences
+// and Alfred Bratterud
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef HTTP_SMALL_VECTOR_HPP
+#define HTTP_SMALL_VECTOR_HPP
+
+#include <new>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <type_traits>
+
+namespace http {
+
+//-----------------------------------------------
+// This class is a sequence container that keeps
+// its first <N> elements within itself and only
+// allocates from the heap beyond that
+//
+// It is limited to trivially copyable types so
+// elements can be moved around as plain bytes
+//
+// @tparam T - The type of the elements
+// @tparam N - The number of elements kept inline
+//-----------------------------------------------
+template <typename T, std::size_t N>
+class Small_vector {
+  static_assert(std::is_trivially_copy_constructible<T>::value
+                and std::is_trivially_destructible<T>::value,
+                "Small_vector is limited to trivially copyable types");
+  static_assert(N > 0, "Small_vector needs inline capacity");
+public:
+  using value_type     = T;
+  using iterator       = T*;
+  using const_iterator = const T*;
+
+  //-----------------------------------------------
+  // Default constructor
+  //-----------------------------------------------
+  Small_vector() noexcept;
+
+  //-----------------------------------------------
+  // Copy constructor
+  //-----------------------------------------------
+  Small_vector(const Small_vector&);
+
+  //-----------------------------------------------
+  // Move constructor
+  //-----------------------------------------------
+  Small_vector(Small_vector&&) noexcept;
+
+  //-----------------------------------------------
+  // Destructor
+  //-----------------------------------------------
+  ~Small_vector() noexcept;
+
+  //-----------------------------------------------
+  // Copy assignment operator
+  //-----------------------------------------------
+  Small_vector& operator = (const Small_vector&);
+
+  //-----------------------------------------------
+  // Move assignment operator
+  //-----------------------------------------------
+  Small_vector& operator = (Small_vector&&) noexcept;
+
+  //-----------------------------------------------
+  // Make room for the specified number of
+  // elements
+  //
+  // @param capacity - The number of elements
+  //-----------------------------------------------
+  void reserve(const std::size_t capacity);
+
+  //-----------------------------------------------
+  // Construct an element at the end of the
+  // sequence
+  //
+  // @param args - The arguments of the constructor
+  //               of the element
+  //
+  // @return - The new element
+  //-----------------------------------------------
+  template <typename... Args>
+  T& emplace_back(Args&&... args);
+
+  //-----------------------------------------------
+  // Add an element at the end of the sequence
+  //
+  // @param value - The element to add
+  //-----------------------------------------------
+  void push_back(const T& value);
+
+  //-----------------------------------------------
+  // Remove an element from the sequence
+  //
+  // @param position - The location of the element
+  //
+  // @return - Iterator to the element that followed
+  //           the one removed
+  //-----------------------------------------------
+  iterator erase(const_iterator position) noexcept;
+
+  //-----------------------------------------------
+  // Remove all elements from the sequence, the
+  // storage is kept
+  //-----------------------------------------------
+  void clear() noexcept;
+
+  std::size_t size()     const noexcept { return size_; }
+  std::size_t capacity() const noexcept { return capacity_; }
+  bool        empty()    const noexcept { return size_ == 0; }
+
+  iterator       begin()       noexcept { return data_; }
+  const_iterator begin() const noexcept { return data_; }
+  iterator       end()         noexcept { return data_ + size_; }
+  const_iterator end()   const noexcept { return data_ + size_; }
+
+  T&       operator [] (const std::size_t i)       noexcept { return data_[i]; }
+  const T& operator [] (const std::size_t i) const noexcept { return data_[i]; }
+private:
+  //-----------------------------------------------
+  // Class data members
+  //-----------------------------------------------
+  T*          data_;
+  std::size_t size_;
+  std::size_t capacity_;
+  typename std::aligned_storage<sizeof(T) * N, alignof(T)>::type inline_;
+
+  T* inline_data() noexcept
+  { return reinterpret_cast<T*>(&inline_); }
+
+  bool is_inline() const noexcept
+  { return data_ == reinterpret_cast<const T*>(&inline_); }
+
+  //-----------------------------------------------
+  // Copy elements as plain bytes, the ranges
+  // may overlap
+  //-----------------------------------------------
+  static void move_bytes(T* to, const T* from, const std::size_t count) noexcept
+  { std::memmove(static_cast<void*>(to), from, count * sizeof(T)); }
+
+  //-----------------------------------------------
+  // Take the elements of another container that
+  // is left empty
+  //-----------------------------------------------
+  void steal(Small_vector& other) noexcept;
+
+  //-----------------------------------------------
+  // Return heap storage and go back to the
+  // inline storage
+  //-----------------------------------------------
+  void release() noexcept;
+}; //< class Small_vector
+
+/**--v----------- Implementation Details -----------v--**/
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T, std::size_t N>
+inline Small_vector<T, N>::Small_vector() noexcept
+  : data_{inline_data()}
+  , size_{0}
+  , capacity_{N}
+{}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T, std::size_t N>
+inline Small_vector<T, N>::Small_vector(const Small_vector& other)
+  : Small_vector{}
+{
+  *this = other;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T, std::size_t N>
+inline Small_vector<T, N>::Small_vector(Small_vector&& other) noexcept
+  : Small_vector{}
+{
+  steal(other);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T, std::size_t N>
+inline Small_vector<T, N>::~Small_vector() noexcept {
+  release();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T, std::size_t N>
+inline Small_vector<T, N>& Small_vector<T, N>::operator = (const Small_vector& other) {
+  if (this == &other) return *this;
+  //-----------------------------------
+  size_ = 0;
+  reserve(other.size_);
+  if (other.size_ not_eq 0) move_bytes(data_, other.data_, other.size_);
+  size_ = other.size_;
+  //-----------------------------------
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T, std::size_t N>
+inline Small_vector<T, N>& Small_vector<T, N>::operator = (Small_vector&& other) noexcept {
+  if (this == &other) return *this;
+  //-----------------------------------
+  release();
+  steal(other);
+  //-----------------------------------
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T, std::size_t N>
+inline void Small_vector<T, N>::reserve(const std::size_t capacity) {
+  if (capacity <= capacity_) return;
+  //-----------------------------------
+  auto data = static_cast<T*>(::operator new(capacity * sizeof(T)));
+  if (size_ not_eq 0) move_bytes(data, data_, size_);
+  //-----------------------------------
+  const auto size = size_;
+  release();
+  data_     = data;
+  size_     = size;
+  capacity_ = capacity;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T, std::size_t N>
+template <typename... Args>
+inline T& Small_vector<T, N>::emplace_back(Args&&... args) {
+  //-----------------------------------
+  // The arguments may refer to an element
+  // so the new one is built before growing
+  //-----------------------------------
+  const T value (std::forward<Args>(args)...);
+  push_back(value);
+  return data_[size_ - 1];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T, std::size_t N>
+inline void Small_vector<T, N>::push_back(const T& value) {
+  if (size_ == capacity_) {
+    const T copy = value;
+    reserve(capacity_ * 2);
+    move_bytes(data_ + size_, &copy, 1);
+  } else {
+    move_bytes(data_ + size_, &value, 1);
+  }
+  ++size_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T, std::size_t N>
+inline typename Small_vector<T, N>::iterator
+Small_vector<T, N>::erase(const_iterator position) noexcept {
+  const auto target = data_ + (position - data_);
+  //-----------------------------------
+  move_bytes(target, target + 1, end() - (target + 1));
+  --size_;
+  //-----------------------------------
+  return target;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T, std::size_t N>
+inline void Small_vector<T, N>::clear() noexcept {
+  size_ = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T, std::size_t N>
+inline void Small_vector<T, N>::steal(Small_vector& other) noexcept {
+  if (other.is_inline()) {
+    move_bytes(data_, other.data_, other.size_);
+  } else {
+    data_     = other.data_;
+    capacity_ = other.capacity_;
+    other.data_     = other.inline_data();
+    other.capacity_ = N;
+  }
+  size_ = other.size_;
+  other.size_ = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T, std::size_t N>
+inline void Small_vector<T, N>::release() noexcept {
+  if (not is_inline()) ::operator delete(data_);
+  data_     = inline_data();
+  size_     = 0;
+  capacity_ = N;
+}
+
+/**--^----------- Implementation Details -----------^--**/
+
+} //< namespace http
+
+#endif //< HTTP_SMALL_VECTOR_HPP
@@ -96,7 +96,7 @@ struct span {
 // an output device
 //-----------------------------------------------
 inline std::ostream& operator << (std::ostream& output_device, const span& span) {
-  return output_device << span.to_string();
+  return output_device.write(span.data, span.len);
 }
 
 /**--^----------- Implementation Details -----------^--**/
@@ -18,87 +18,202 @@
 #ifndef HTTP_STATUS_CODES_HPP
 #define HTTP_STATUS_CODES_HPP
 
-#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+#include "span.hpp"
+#include "version.hpp"
 
 namespace http {
 //------------------------------------------------
-using Code              = int;
-using Description       = const char*;
-using Status_Code_Table = std::unordered_map<Code, Description>;
+using Code        = int;
+using Description = const char*;
+//------------------------------------------------
+// The known status codes, as (code, description)
+//------------------------------------------------
+#define HTTP_STATUS_CODE_MAP(XX)                                                          \
+  /* 1xx: Informational - Request received, continuing process */                         \
+  XX(100, "Continue")                                                                     \
+  XX(101, "Switching Protocols")                                                          \
+  XX(102, "Processing")                                                                   \
+  /* 2xx: Success - The action was successfully received, understood, and accepted */     \
+  XX(200, "OK")                                                                           \
+  XX(201, "Created")                                                                      \
+  XX(202, "Accepted")                                                                     \
+  XX(203, "Non-Authoritative Information")                                                \
+  XX(204, "No Content")                                                                   \
+  XX(205, "Reset Content")                                                                \
+  XX(206, "Partial Content")                                                              \
+  XX(207, "Multi-Status")                                                                 \
+  XX(208, "Already Reported")                                                             \
+  XX(226, "IM Used")                                                                      \
+  /* 3xx: Redirection - Further action must be taken in order to complete the request */  \
+  XX(300, "Multiple Choices")                                                             \
+  XX(301, "Moved Permanently")                                                            \
+  XX(302, "Found")                                                                        \
+  XX(303, "See Other")                                                                    \
+  XX(304, "Not Modified")                                                                 \
+  XX(305, "Use Proxy")                                                                    \
+  XX(307, "Temporary Redirect")                                                           \
+  XX(308, "Permanent Redirect")                                                           \
+  /* 4xx: Client Error - The request contains bad syntax or cannot be fulfilled */        \
+  XX(400, "Bad Request")                                                                  \
+  XX(401, "Unauthorized")                                                                 \
+  XX(402, "Payment Required")                                                             \
+  XX(403, "Forbidden")                                                                    \
+  XX(404, "Not Found")                                                                    \
+  XX(405, "Method Not Allowed")                                                           \
+  XX(406, "Not Acceptable")                                                               \
+  XX(407, "Proxy Authentication Required")                                                \
+  XX(408, "Request Timeout")                                                              \
+  XX(409, "Conflict")                                                                     \
+  XX(410, "Gone")                                                                         \
+  XX(411, "Length Required")                                                              \
+  XX(412, "Precondition Failed")                                                          \
+  XX(413, "Payload Too Large")                                                            \
+  XX(414, "URI Too Long")                                                                 \
+  XX(415, "Unsupported Media Type")                                                       \
+  XX(416, "Range Not Satisfiable")                                                        \
+  XX(417, "Expectation Failed")                                                           \
+  XX(421, "Misdirected Request")                                                          \
+  XX(422, "Unprocessable Entity")                                                         \
+  XX(423, "Locked")                                                                       \
+  XX(424, "Failed Dependency")                                                            \
+  XX(426, "Upgrade Required")                                                             \
+  XX(428, "Precondition Required")                                                        \
+  XX(429, "Too Many Requests")                                                            \
+  XX(431, "Request Header Fields Too Large")                                              \
+  /* 5xx: Server Error - The server failed to fulfill an apparently valid request */      \
+  XX(500, "Internal Server Error")                                                        \
+  XX(501, "Not Implemented")                                                              \
+  XX(502, "Bad Gateway")                                                                  \
+  XX(503, "Service Unavailable")                                                          \
+  XX(504, "Gateway Timeout")                                                              \
+  XX(505, "HTTP Version Not Supported")                                                   \
+  XX(506, "Variant Also Negotiates")                                                      \
+  XX(507, "Insufficient Storage")                                                         \
+  XX(508, "Loop Detected")                                                                \
+  XX(510, "Not Extended")                                                                 \
+  XX(511, "Network Authentication Required")
+
+namespace status {
+//------------------------------------------------
+// A known status code with its description
+//------------------------------------------------
+struct Entry {
+  Code        code;
+  Description description;
+  size_t      len;
+};
+
+constexpr Entry entries[] {
+#define XX(code, description) {code, description, sizeof(description) - 1},
+  HTTP_STATUS_CODE_MAP(XX)
+#undef XX
+};
+
+constexpr size_t entry_count {sizeof(entries) / sizeof(entries[0])};
+
+//------------------------------------------------
+// The status lines are indexed by code - <First>
+//------------------------------------------------
+constexpr Code   First {100};
+constexpr size_t Count {412};
+
+//------------------------------------------------
+// Length of "HTTP/1.1 200 OK\r\n" for an entry
+//------------------------------------------------
+constexpr size_t line_len(const Entry& entry) noexcept {
+  return 13 + entry.len + 2;
+}
+
+constexpr size_t text_size() noexcept {
+  size_t size = 0;
+  for (const auto& entry : entries) size += 2 * line_len(entry);
+  return size;
+}
+
+static_assert(text_size() <= UINT16_MAX, "The status lines don't fit 16-bit offsets");
+
+//------------------------------------------------
+// The complete status lines of the known codes,
+// for HTTP/1.0 followed by HTTP/1.1, so writing
+// one is a single copy
 //------------------------------------------------
-const Status_Code_Table status_codes {
-  //< 1xx: Informational - Request received, continuing process
-  {100, "Continue"},
-  {101, "Switching Protocols"},
-  {102, "Processing"},
-
-  //< 2xx: Success - The action was successfully received, understood, and accepted
-  {200, "OK"},
-  {201, "Created"},
-  {202, "Accepted"},
-  {203, "Non-Authoritative Information"},
-  {204, "No Content"},
-  {205, "Reset Content"},
-  {206, "Partial Content"},
-  {207, "Multi-Status"},
-  {208, "Already Reported"},
-  {226, "IM Used"},
-
-  //< 3xx: Redirection - Further action must be taken in order to complete the request
-  {300, "Multiple Choices"},
-  {301, "Moved Permanently"},
-  {302, "Found"},
-  {303, "See Other"},
-  {304, "Not Modified"},
-  {305, "Use Proxy"},
-  {307, "Temporary Redirect"},
-  {308, "Permanent Redirect"},
-
-  //< 4xx: Client Error - The request contains bad syntax or cannot be fulfilled
-  {400, "Bad Request"},
-  {401, "Unauthorized"},
-  {402, "Payment Required"},
-  {403, "Forbidden"},
-  {404, "Not Found"},
-  {405, "Method Not Allowed"},
-  {406, "Not Acceptable"},
-  {407, "Proxy Authentication Required"},
-  {408, "Request Timeout"},
-  {409, "Conflict"},
-  {410, "Gone"},
-  {411, "Length Required"},
-  {412, "Precondition Failed"},
-  {413, "Payload Too Large"},
-  {414, "URI Too Long"},
-  {415, "Unsupported Media Type"},
-  {416, "Range Not Satisfiable"},
-  {417, "Expectation Failed"},
-  {421, "Misdirected Request"},
-  {422, "Unprocessable Entity"},
-  {423, "Locked"},
-  {424, "Failed Dependency"},
-  {426, "Upgrade Required"},
-  {428, "Precondition Required"},
-  {429, "Too Many Requests"},
-  {431, "Request Header Fields Too Large"},
-
-  //< 5xx: Server Error - The server failed to fulfill an apparently valid request
-  {500, "Internal Server Error"},
-  {501, "Not Implemented"},
-  {502, "Bad Gateway"},
-  {503, "Service Unavailable"},
-  {504, "Gateway Timeout"},
-  {505, "HTTP Version Not Supported"},
-  {506, "Variant Also Negotiates"},
-  {507, "Insufficient Storage"},
-  {508, "Loop Detected"},
-  {510, "Not Extended"},
-  {511, "Network Authentication Required"}
-}; //< status_codes
+struct Lines {
+  char     text[text_size()];
+  uint16_t offset[Count]; //< Of the HTTP/1.0 line
+  uint8_t  len[Count];    //< 0 if the code is unknown
+  uint8_t  entry[Count];  //< Index into <entries>
+};
+
+constexpr Lines make_lines() noexcept {
+  Lines lines {};
+  size_t at = 0;
+  //-----------------------------------
+  for (size_t e = 0; e < entry_count; ++e) {
+    const auto& entry = entries[e];
+    const auto  i     = static_cast<size_t>(entry.code - First);
+    //-----------------------------------
+    lines.offset[i] = static_cast<uint16_t>(at);
+    lines.len[i]    = static_cast<uint8_t>(line_len(entry));
+    lines.entry[i]  = static_cast<uint8_t>(e);
+    //-----------------------------------
+    for (char minor = '0'; minor <= '1'; ++minor) {
+      for (const char c : {'H', 'T', 'T', 'P', '/', '1', '.', minor, ' ',
+                           static_cast<char>('0' + entry.code / 100),
+                           static_cast<char>('0' + entry.code / 10 % 10),
+                           static_cast<char>('0' + entry.code % 10), ' '}) {
+        lines.text[at++] = c;
+      }
+      for (size_t c = 0; c < entry.len; ++c) lines.text[at++] = entry.description[c];
+      lines.text[at++] = '\r';
+      lines.text[at++] = '\n';
+    }
+  }
+  //-----------------------------------
+  return lines;
+}
+
+template <typename = void>
+struct Tables {
+  static constexpr Lines lines {make_lines()};
+};
+
+template <typename T>
+constexpr Lines Tables<T>::lines;
+} //< namespace status
+
+//------------------------------------------------
+// Get the complete status line of a response
+//
+// @param code    - The status code
+// @param version - The version of the response
+//
+// @return - The status line, such as
+//           "HTTP/1.1 200 OK\r\n", without data
+//           if the code is unknown or the version
+//           isn't HTTP/1.0 or HTTP/1.1
+//------------------------------------------------
+inline span status_line(const Code code, const Version& version) noexcept {
+  const auto& lines = status::Tables<>::lines;
+  const auto  i     = static_cast<size_t>(code - status::First);
+  //-----------------------------------
+  if (i >= status::Count or lines.len[i] == 0
+      or version.get_major() not_eq 1 or version.get_minor() > 1) {
+    return {};
+  }
+  //-----------------------------------
+  return {lines.text + lines.offset[i] + version.get_minor() * lines.len[i], lines.len[i]};
+}
 
 inline Description code_description(const Code code) noexcept {
-  auto iter = status_codes.find(code);
-  return (iter not_eq status_codes.end()) ? iter->second : "Internal Server Error";
+  const auto& lines = status::Tables<>::lines;
+  const auto  i     = static_cast<size_t>(code - status::First);
+  //-----------------------------------
+  return (i < status::Count and lines.len[i] not_eq 0)
+         ? status::entries[lines.entry[i]].description
+         : "Internal Server Error";
 }
 
 } //< namespace http
@@ -20,12 +20,18 @@
 
 #include <ctime>
 #include <string>
-#include <sstream>
-#include <iomanip>
+
+#include "span.hpp"
 
 namespace http {
 namespace time {
 
+//------------------------------------------------
+// The length of an IMF-fixdate, such as
+// "Sun, 06 Nov 1994 08:49:37 GMT"
+//------------------------------------------------
+constexpr size_t Date_len {29};
+
 //------------------------------------------------
 // Get the time in {Internet Standard Format} from
 // a {time_t} object 
@@ -38,6 +44,41 @@ namespace time {
 //------------------------------------------------
 std::string from_time_t(const std::time_t time_);
 
+//------------------------------------------------
+// Format a time as an IMF-fixdate
+//
+// The time is taken as UTC and formatted without
+// the C library, so neither the locale nor the
+// timezone of the host matters
+//
+// @param time_ - The time to format
+// @param out   - Where to write, at least <Date_len> bytes
+//
+// @return <Date_len>, or 0 if the year doesn't have
+//         four digits
+//------------------------------------------------
+size_t format_date(const std::time_t time_, char* out) noexcept;
+
+//------------------------------------------------
+// Parse a timestamp in any of the formats of
+// RFC 7231 §7.1.1.1:
+//
+// Sun, 06 Nov 1994 08:49:37 GMT  ; IMF-fixdate
+// Sunday, 06-Nov-94 08:49:37 GMT ; RFC 850
+// Sun Nov  6 08:49:37 1994       ; asctime
+//
+// The timestamp is taken as UTC. A two-digit year
+// more than 50 years in the future is taken to be
+// in the past century
+//
+// @param time_  - The timestamp
+// @param result - Set to the time if it was parsed
+//
+// @return true if the timestamp was parsed,
+//         false otherwise
+//------------------------------------------------
+bool parse_date(const span& time_, std::time_t& result) noexcept;
+
 //------------------------------------------------
 // Get a {time_t} object from a {std::string} representing
 // timestamps specified in RFC 2616 §3.3
@@ -59,6 +100,20 @@ std::time_t to_time_t(const std::string& time_);
 //------------------------------------------------
 std::string now();
 
+//------------------------------------------------
+// Get the current time as an IMF-fixdate without
+// formatting it on every call
+//
+// The text is kept for each thread and formatted
+// at most once per second, so it stays unchanged
+// until the same thread asks again in a later
+// second
+//
+// @return The current time, <Date_len> bytes, or
+//         without data if an error occurred
+//------------------------------------------------
+span date() noexcept;
+
 } //< namespace time
 } //< namespace http
 
@@ -19,7 +19,7 @@
 #define HTTP_VERSION_HPP
 
 #include <string>
-#include <sstream>
+#include <ostream>
 
 namespace http {
 
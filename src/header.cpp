@@ -17,28 +17,32 @@
 
 #include <header.hpp>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace http {
 
 ///////////////////////////////////////////////////////////////////////////////
-Header::Header() {
-  map_.reserve(100);
-}
+Header::Header()
+  : limit_{100}
+{}
 
 ///////////////////////////////////////////////////////////////////////////////
-Header::Header(const Limit limit) noexcept {
-  if (limit <= 0) {
-    map_.reserve(100);
-  } else {
-    map_.reserve(limit);
-  }
-}
+Header::Header(const Limit limit) noexcept
+  : limit_{(limit <= 0) ? 100 : limit}
+{}
 
 ///////////////////////////////////////////////////////////////////////////////
-bool Header::add_field(const span& field, const span& value) {
+bool Header::add_field(const span& field, const span& value, const Span_bases& bases) {
   if (field.is_empty()) return false;
   //-----------------------------------
-  if (size() < map_.capacity()) {
-    map_.emplace_back(field, value);
+  if (size() < limit_) {
+    const auto hash = header::hash(field.data, field.len);
+    names_.push_back(compact(field, bases));
+    values_.push_back(compact(value, bases));
+    ids_.push_back(header::classify(field, hash));
+    keys_.push_back(header::key(hash));
     return true;
   }
   //-----------------------------------
@@ -46,77 +50,235 @@ bool Header::add_field(const span& field, const span& value) {
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-bool Header::set_field(const span& field, const span& value) {
+bool Header::set_field(const span& field, const span& value, const Span_bases& bases) {
   if (field.is_empty() || value.is_empty()) return false;
   //-----------------------------------
-  auto target = find(field);
+  const auto target = find(field, bases);
   //-----------------------------------
-  if (target not_eq map_.end()) {
-    const_cast<span&>(target->second).data = value.data;
-    const_cast<span&>(target->second).len  = value.len;
+  if (target not_eq size()) {
+    auto& current = values_[target];
+    current = compact(value, bases, &current);
     return true;
   }
   //-----------------------------------
-  else return add_field(field, value);
+  else return add_field(field, value, bases);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool Header::has_field(const span& field, const Span_bases& bases) const noexcept {
+  return find(field, bases) not_eq size();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool Header::has_field(const header::Field& field) const noexcept {
+  return find(field.id) not_eq size();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-bool Header::has_field(const span& field) const noexcept {
-  return find(field) not_eq map_.end();
+span Header::get_value(const span& field, const Span_bases& bases) const noexcept {
+  return expand(values_[find(field, bases)], bases);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-const span& Header::get_value(const span& field) const noexcept {
-  return find(field)->second;
+span Header::get_value(const header::Field& field, const Span_bases& bases) const noexcept {
+  return expand(values_[find(field.id)], bases);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+span Header::find_value(const span& field, const Span_bases& bases) const noexcept {
+  const auto target = find(field, bases);
+  return (target not_eq size()) ? expand(values_[target], bases) : span{};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+span Header::find_value(const header::Field& field, const Span_bases& bases) const noexcept {
+  const auto target = find(field.id);
+  return (target not_eq size()) ? expand(values_[target], bases) : span{};
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 bool Header::is_empty() const noexcept {
-  return map_.empty();
+  return names_.empty();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 Limit Header::size() const noexcept {
-  return map_.size();
+  return names_.size();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-void Header::erase(const span& field) noexcept {
-  auto target = find(field);
-  //-----------------------------------
-  if (target not_eq map_.end()) map_.erase(target);
+void Header::erase(const span& field, const Span_bases& bases) noexcept {
+  const auto target = find(field, bases);
+  if (target not_eq size()) erase(target);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Header::erase(const size_t index) noexcept {
+  names_.erase(names_.begin() + index);
+  values_.erase(values_.begin() + index);
+  ids_.erase(ids_.begin() + index);
+  keys_.erase(keys_.begin() + index);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 void Header::clear() noexcept {
-  map_.clear();
+  names_.clear();
+  values_.clear();
+  ids_.clear();
+  keys_.clear();
+  external_.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Compact_span Header::compact(const span& s, const Span_bases& bases,
+                             const Compact_span* previous) {
+  const auto o = bases.to_offset(s);
+  //-----------------------------------
+  if (o.base not_eq Offset_span::Absolute
+      and o.offset <= Compact_span::Max_offset
+      and o.len    <= Compact_span::Max_len)
+  {
+    return {static_cast<Compact_span::Base>(o.base),
+            static_cast<uint32_t>(o.offset), static_cast<uint32_t>(o.len)};
+  }
+  //-----------------------------------
+  if (previous not_eq nullptr and previous->base() == Compact_span::External) {
+    external_[previous->offset()] = s;
+    return *previous;
+  }
+  //-----------------------------------
+  external_.push_back(s);
+  return {Compact_span::External, static_cast<uint32_t>(external_.size() - 1), 0};
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-static std::string string_to_lower_case(std::string string) {
-  std::transform(string.begin(), string.end(),
-                 string.begin(), ::tolower);
+span Header::expand(const Compact_span& c, const Span_bases& bases) const noexcept {
+  if (c.base() == Compact_span::External) return external_[c.offset()];
   //-----------------------------------
-  return string;
+  return bases.to_span({c.offset(), c.len(), static_cast<Offset_span::Base>(c.base())});
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-Header::Const_Iterator Header::find(const span& field) const noexcept {
-  if (field.is_empty()) return map_.end();
+static inline uint64_t load_word(const char* data) noexcept {
+  uint64_t word;
+  std::memcpy(&word, data, sizeof word);
+  return word;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static inline uint64_t fold_word(const uint64_t word) noexcept {
+  constexpr uint64_t ones = 0x0101010101010101ULL;
+  //-----------------------------------
+  // Each byte of ASCII gets its high bit
+  // set by the addition if it is at least
+  // 'A' or greater than 'Z' respectively,
+  // so bytes that differ are upper case
+  //-----------------------------------
+  const uint64_t ascii = word & (0x7f * ones);
+  const uint64_t upper = ((ascii + (0x80 - 'A') * ones)
+                          ^ (ascii + (0x80 - 'Z' - 1) * ones))
+                         & ~word & (0x80 * ones);
   //-----------------------------------
-  return
-  std::find_if(map_.begin(), map_.end(), [&field](const auto& f){
-    return string_to_lower_case(f.first.to_string())
-           ==
-           string_to_lower_case(field.to_string());
-  });
+  return word | (upper >> 2);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static inline char fold_char(const char c) noexcept {
+  return static_cast<char>(c | ((static_cast<unsigned char>(c - 'A') < 26) << 5));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static bool equal_ignore_case(const span& lhs, const span& rhs) noexcept {
+  if (lhs.len not_eq rhs.len) return false;
+  //-----------------------------------
+  // Field names are ASCII so eight bytes
+  // are folded and compared at once
+  //-----------------------------------
+  size_t i = 0;
+  //-----------------------------------
+  for (; i + sizeof(uint64_t) <= lhs.len; i += sizeof(uint64_t)) {
+    if (fold_word(load_word(lhs.data + i)) not_eq fold_word(load_word(rhs.data + i))) {
+      return false;
+    }
+  }
+  //-----------------------------------
+  for (; i < lhs.len; ++i) {
+    if (fold_char(lhs.data[i]) not_eq fold_char(rhs.data[i])) return false;
+  }
+  //-----------------------------------
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static size_t find_key(const uint16_t* keys, const size_t size, size_t from,
+                       const uint16_t key) noexcept {
+#if defined(__SSE2__)
+  //-----------------------------------
+  // Eight keys are compared at once, each
+  // match sets two bits of the mask
+  //-----------------------------------
+  const __m128i target = _mm_set1_epi16(static_cast<short>(key));
+  //-----------------------------------
+  for (; from + 8 <= size; from += 8) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + from));
+    const auto    mask  = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi16(block, target)));
+    if (mask not_eq 0) return from + (__builtin_ctz(mask) >> 1);
+  }
+#endif
+  //-----------------------------------
+  for (; from < size; ++from) {
+    if (keys[from] == key) return from;
+  }
+  //-----------------------------------
+  return size;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+size_t Header::find(const span& field, const Span_bases& bases) const noexcept {
+  if (field.is_empty()) return size();
+  return find(prepare(field), 0, bases);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Header::Lookup Header::prepare(const span& field) noexcept {
+  const auto hash = header::hash(field.data, field.len);
+  return {field, header::classify(field, hash), header::key(hash)};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+size_t Header::find(const Lookup& lookup, const size_t from, const Span_bases& bases) const noexcept {
+  if (lookup.id not_eq header::Field_id::Unknown) {
+    return std::find(ids_.begin() + std::min(from, size()), ids_.end(), lookup.id) - ids_.begin();
+  }
+  //-----------------------------------
+  // Only fields that are not well-known
+  // can have the same name, and only the
+  // names of those with the same key are
+  // compared
+  //-----------------------------------
+  for (auto i = find_key(keys_.begin(), size(), from, lookup.key);
+       i < size();
+       i = find_key(keys_.begin(), size(), i + 1, lookup.key))
+  {
+    if (ids_[i] == header::Field_id::Unknown
+        and equal_ignore_case(expand(names_[i], bases), lookup.field))
+    {
+      return i;
+    }
+  }
+  //-----------------------------------
+  return size();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+size_t Header::find(const header::Field_id id) const noexcept {
+  return std::find(ids_.begin(), ids_.end(), id) - ids_.begin();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 std::ostream& operator << (std::ostream& output_device, const Header& header) {
-  for (const auto& field : header.map_) {
-    output_device << field.first  << ": "
-                  << field.second << "\r\n";
+  for (const auto field : header) {
+    output_device << field.first << ": " << field.second << "\r\n";
   }
   //-----------------------------------
   return output_device << "\r\n";
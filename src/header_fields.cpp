@@ -15,62 +15,70 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+
+#include <header_fields.hpp>
+
 namespace http {
 namespace header {
 //------------------------------------------------
-using Field = const char*;
-//------------------------------------------------
-// Request Fields
-//------------------------------------------------
-Field Accept              {"Accept"};
-Field Accept_Charset      {"Accept-Charset"};
-Field Accept_Encoding     {"Accept-Encoding"};
-Field Accept_Language     {"Accept-Language"};
-Field Authorization       {"Authorization"};
-Field Connection          {"Connection"};
-Field Expect              {"Expect"};
-Field From                {"From"};
-Field Host                {"Host"};
-Field HTTP2_Settings      {"HTTP2-Settings"};
-Field If_Match            {"If-Match"};
-Field If_Modified_Since   {"If-Modified-Since"};
-Field If_None_Match       {"If-None-Match"};
-Field If_Range            {"If-Range"};
-Field If_Unmodified_Since {"If-Unmodified-Since"};
-Field Max_Forwards        {"Max-Forwards"};
-Field Proxy_Authorization {"Proxy-Authorization"};
-Field Range               {"Range"};
-Field Referer             {"Referer"};
-Field TE                  {"TE"};
-Field Upgrade             {"Upgrade"};
-Field User_Agent          {"User-Agent"};
-//------------------------------------------------
-// Response Fields
-//------------------------------------------------
-Field Accept_Ranges       {"Accept-Ranges"};
-Field Age                 {"Age"};
-Field Date                {"Date"};
-Field ETag                {"ETag"};
-Field Location            {"Location"};
-Field Proxy_Authenticate  {"Proxy-Authenticate"};
-Field Retry_After         {"Retry-After"};
-Field Server              {"Server"};
-Field Vary                {"Vary"};
-Field WWW_Authenticate    {"WWW-Authenticate"};
+// The well-known fields indexed by identifier
 //------------------------------------------------
-// Entity Fields
+static constexpr Field fields[] {
+  {"", Field_id::Unknown},
+#define XX(id, name) id,
+  HTTP_HEADER_FIELD_MAP(XX)
+#undef XX
+};
+
 //------------------------------------------------
-Field Allow               {"Allow"};
-Field Content_Encoding    {"Content-Encoding"};
-Field Content_Language    {"Content-Language"};
-Field Content_Length      {"Content-Length"};
-Field Content_Location    {"Content-Location"};
-Field Content_MD5         {"Content-MD5"};
-Field Content_Range       {"Content-Range"};
-Field Content_Type        {"Content-Type"};
-Field Expires             {"Expires"};
-Field Last_Modified       {"Last-Modified"};
+// Maps the slot of a hash to the identifier
+// of the well-known field that hashes to it
 //------------------------------------------------
+struct Slot_table {
+  Field_id slots[Slots];
+  bool     perfect;
+};
+
+static constexpr Slot_table make_slot_table() noexcept {
+  Slot_table table {{}, true};
+  //-----------------------------------
+  for (const auto& field : fields) {
+    if (field.id == Field_id::Unknown) continue;
+    //-----------------------------------
+    auto& target = table.slots[slot(field.hash)];
+    if (target not_eq Field_id::Unknown) table.perfect = false;
+    target = field.id;
+  }
+  //-----------------------------------
+  return table;
+}
+
+static constexpr Slot_table slot_table {make_slot_table()};
+
+static_assert(slot_table.perfect,
+              "Two well-known fields share a slot, choose another header::Seed");
+
+///////////////////////////////////////////////////////////////////////////////
+Field_id classify(const span& field) noexcept {
+  return classify(field, hash(field.data, field.len));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Field_id classify(const span& field, const uint32_t hash) noexcept {
+  const auto  id        = slot_table.slots[slot(hash)];
+  const auto& candidate = fields[static_cast<size_t>(id)];
+  //-----------------------------------
+  if (candidate.len not_eq field.len) return Field_id::Unknown;
+  //-----------------------------------
+  // The hash folds case so the name
+  // must be compared the same way
+  //-----------------------------------
+  for (size_t i = 0; i < field.len; ++i) {
+    if (fold(candidate.name[i]) not_eq fold(field.data[i])) return Field_id::Unknown;
+  }
+  //-----------------------------------
+  return id;
+}
 //------------------------------------------------
 } //< namespace header
 } //< namespace http
@@ -19,52 +19,301 @@
 
 namespace http {
 
+//-----------------------------------
+// Enough for the fields that are
+// usually added to a response, so
+// the arena is allocated only once
+//-----------------------------------
+static constexpr size_t arena_block {256};
+
 ///////////////////////////////////////////////////////////////////////////////
 Message::Message(const Limit limit) noexcept
   : header_fields_{limit}
 {}
 
+///////////////////////////////////////////////////////////////////////////////
+Message::Message(const Message& other)
+  : header_fields_{other.header_fields()}
+  , header_block_{other.header_block_}
+  , indexed_{other.indexed_}
+  , message_body_{other.message_body_}
+  , body_view_{other.body_view_}
+  , arena_{other.arena_}
+  , info_{other.info_}
+  , host_{other.host_}
+{}
+
+///////////////////////////////////////////////////////////////////////////////
+Message& Message::operator = (const Message& other) {
+  header_fields_ = other.header_fields();
+  header_block_  = other.header_block_;
+  indexed_       = other.indexed_;
+  message_body_  = other.message_body_;
+  body_view_     = other.body_view_;
+  arena_         = other.arena_;
+  info_          = other.info_;
+  host_          = other.host_;
+  return *this;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 Message& Message::add_header(const span& field, const span& value) {
-  header_fields_.add_field(field, value);
+  const auto name = store(field);
+  const auto data = store(value);
+  //-----------------------------------
+  // Storing the value may have moved
+  // the arena, so the spans are made
+  // from the offsets afterwards
+  //-----------------------------------
+  const auto b = bases();
+  header_fields().add_field(b.to_span(name), b.to_span(data), b);
   return *this;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 Message& Message::set_header(const span& field, const span& value) {
-  header_fields_.set_field(field, value);
+  const auto current = header_fields().find_value(field, bases());
+  //-----------------------------------
+  if (current.data == nullptr) return add_header(field, value);
+  //-----------------------------------
+  // The old value is left in the arena
+  // since other fields may share it
+  //-----------------------------------
+  const auto name = bases().to_offset(field);
+  const auto data = store(value);
+  const auto b    = bases();
+  //-----------------------------------
+  header_fields().set_field(b.to_span(name), b.to_span(data), b);
   return *this;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-const span& Message::header_value(const span& field) const noexcept {
-  return header_fields_.get_value(field);
+span Message::header_value(const span& field) const noexcept {
+  return header_fields().get_value(field, bases());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+span Message::header_value(const header::Field& field) const noexcept {
+  return header_fields().get_value(field, bases());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+span Message::find_header_value(const span& field) const noexcept {
+  return header_fields().find_value(field, bases());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+span Message::find_header_value(const header::Field& field) const noexcept {
+  return header_fields().find_value(field, bases());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Header::Value_range Message::header_values(const span& field) const {
+  return header_fields().get_values(field, bases());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Header::Value_range Message::header_values(const header::Field& field) const {
+  return header_fields().get_values(field, bases());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Header::Fields Message::headers() const {
+  return header_fields().fields(bases());
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 bool Message::has_header(const span& field) const noexcept {
-  return header_fields_.has_field(field);
+  return header_fields().has_field(field, bases());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool Message::has_header(const header::Field& field) const noexcept {
+  return header_fields().has_field(field);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 bool Message::is_header_empty() const noexcept {
-  return header_fields_.is_empty();
+  return header_fields().is_empty();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 Message::HSize Message::header_size() const noexcept {
-  return header_fields_.size();
+  return header_fields().size();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 Message& Message::erase_header(const span& field) noexcept {
-  header_fields_.erase(field);
+  header_fields().erase(field, bases());
   return *this;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 Message& Message::clear_headers() noexcept {
+  header_block_ = Offset_span{};
+  indexed_.reset();
+  host_         = Offset_span{};
   header_fields_.clear();
+  arena_.clear();
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Message& Message::set_header_block(const span& block) noexcept {
+  header_block_ = bases().to_offset(block);
+  indexed_.reset();
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Message& Message::set_info(const Message_info& info) noexcept {
+  info_ = info;
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+const Message_info& Message::info() const noexcept {
+  return info_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+uint64_t Message::content_length() const noexcept {
+  return info_.content_length;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool Message::keep_alive() const noexcept {
+  return info_.flags & Message_info::Keep_alive;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool Message::is_chunked() const noexcept {
+  return info_.flags & Message_info::Chunked;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool Message::is_upgrade() const noexcept {
+  return info_.flags & Message_info::Upgrade;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Message& Message::set_host(const span& host) noexcept {
+  host_ = bases().to_offset(host);
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+span Message::host() const noexcept {
+  return bases().to_span(host_);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Offset_span Message::store(const span& data) {
+  const auto relative = bases().to_offset(data);
+  if (relative.base not_eq Offset_span::Absolute) return relative;
+  //-----------------------------------
+  const auto offset = arena_.size();
+  //-----------------------------------
+  if (offset + data.len > arena_.capacity()) {
+    arena_.reserve(std::max(offset + data.len, std::max(arena_block, 2 * arena_.capacity())));
+  }
+  //-----------------------------------
+  arena_.append(data.data, data.len);
+  return {offset, data.len, Offset_span::Owned};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Message& Message::set_content_length(const size_t size) {
+  char digits[20];
+  char* p = digits + sizeof digits;
+  //-----------------------------------
+  auto n = size;
+  do {
+    *--p = static_cast<char>('0' + n % 10);
+    n /= 10;
+  } while (n not_eq 0);
+  //-----------------------------------
+  info_.content_length = size;
+  info_.flags |= Message_info::Content_length;
+  //-----------------------------------
+  return set_header(header::Content_Length,
+                    {p, static_cast<size_t>(digits + sizeof digits - p)});
+}
+
+///////////////////////////////////////////////////////////////////////////////
+span Message::source() const noexcept {
+  return {};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Span_bases Message::bases() const noexcept {
+  return {source(), {arena_.data(), arena_.size()}};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+const Header& Message::header_fields() const {
+  indexed_([this] { index_headers(); });
+  return header_fields_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Header& Message::header_fields() {
+  indexed_([this] { index_headers(); });
+  return header_fields_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Message::index_headers() const {
+  if (header_block_.len == 0) return;
+  //-----------------------------------
+  const auto b     = bases();
+  const auto block = b.to_span(header_block_);
+  //-----------------------------------
+  const char*       p   = block.data;
+  const char* const end = block.data + block.len;
+  //-----------------------------------
+  span field;
+  span value;
+  //-----------------------------------
+  while (p < end) {
+    //-----------------------------------
+    // A line starting with whitespace
+    // continues the previous value, the
+    // parsers join these lines before the
+    // block is handed over
+    //-----------------------------------
+    const bool folded = (*p == ' ' or *p == '\t');
+    //-----------------------------------
+    if (not folded) {
+      if (not field.is_empty()) header_fields_.add_field(field, value, b);
+      //-----------------------------------
+      auto colon = static_cast<const char*>(std::memchr(p, ':', end - p));
+      if (colon == nullptr) return;
+      //-----------------------------------
+      field = {p, static_cast<size_t>(colon - p)};
+      //-----------------------------------
+      for (p = colon + 1; p < end and (*p == ' ' or *p == '\t'); ++p);
+      value = {p, 0};
+    }
+    //-----------------------------------
+    while (p < end and *p not_eq '\r' and *p not_eq '\n') ++p;
+    value.len = p - value.data;
+    //-----------------------------------
+    if (p < end and *p == '\r') ++p;
+    if (p < end and *p == '\n') ++p;
+  }
+  //-----------------------------------
+  if (not field.is_empty()) header_fields_.add_field(field, value, b);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Message& Message::own_body() {
+  if (body_view_.len == 0) return *this;
+  //-----------------------------------
+  const auto body = bases().to_span(body_view_);
+  message_body_.assign(body.data, body.len);
+  body_view_ = Offset_span{};
+  //-----------------------------------
   return *this;
 }
 
@@ -72,53 +321,139 @@ Message& Message::clear_headers() noexcept {
 Message& Message::add_body(const Message_Body& message_body) {
   if (message_body.empty()) return *this;
   //-----------------------------------
+  body_view_ = Offset_span{};
   message_body_ = message_body;
-  mbody_length_ = std::to_string(message_body_.size());
   //-----------------------------------
-  return add_header(header::Content_Length,
-                    mbody_length_.c_str());
+  return set_content_length(message_body_.size());
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 Message& Message::add_chunk(const std::string& chunk) {
   if (chunk.empty()) return *this;
   //-----------------------------------
+  own_body();
   message_body_.append(chunk);
-  mbody_length_ = std::to_string(message_body_.size());
   //-----------------------------------
-  return set_header(header::Content_Length,
-                    mbody_length_.c_str());
+  return set_content_length(message_body_.size());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Message& Message::reserve_body(const size_t size) {
+  const auto capacity = message_body_.capacity();
+  //-----------------------------------
+  if (size > capacity) {
+    message_body_.reserve(std::max(size, 2 * capacity));
+  }
+  //-----------------------------------
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Message& Message::append_body(const span& data) {
+  own_body();
+  message_body_.append(data.data, data.len);
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Message& Message::complete_body() {
+  const auto body = body_view();
+  //-----------------------------------
+  if (body.len == 0) return *this;
+  //-----------------------------------
+  return set_content_length(body.len);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Message& Message::set_body_view(const span& body) noexcept {
+  message_body_.clear();
+  body_view_ = bases().to_offset(body);
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+span Message::body_view() const noexcept {
+  if (body_view_.len not_eq 0) return bases().to_span(body_view_);
+  return {message_body_.data(), message_body_.size()};
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 bool Message::has_body() const noexcept {
-  return not message_body_.empty();
+  return body_view().len not_eq 0;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-const Message::Message_Body& Message::get_body() const noexcept {
-  return message_body_;
+Message::Message_Body Message::get_body() const {
+  const auto body = body_view();
+  return {body.data, body.len};
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 Message& Message::clear_body() noexcept {
   message_body_.clear();
+  body_view_ = Offset_span{};
+  //-----------------------------------
+  info_.content_length = 0;
+  info_.flags &= ~Message_info::Content_length;
+  //-----------------------------------
   return erase_header(header::Content_Length);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 Message& Message::reset() noexcept {
+  info_ = Message_info{};
   return clear_headers().clear_body();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 std::string Message::to_string() const {
-  std::ostringstream message;
+  std::string message(serialized_size(), '\0');
+  serialize_into(&message[0], message.size());
+  return message;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+size_t Message::serialized_size() const {
+  size_t size = 2 + body_view().len;
+  //-----------------------------------
+  for (const auto field : headers()) {
+    size += field.first.len + field.second.len + 4;
+  }
+  //-----------------------------------
+  return size;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+size_t Message::serialize_into(char* buffer, const size_t len) const {
+  Buffer_writer writer {buffer, len};
+  serialize(writer);
+  return writer.fits() ? writer.size() : 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Message::serialize(Buffer_writer& writer) const {
+  for (const auto field : headers()) {
+    writer.add(field.first);
+    writer.add({": ", 2});
+    writer.add(field.second);
+    writer.add({"\r\n", 2});
+  }
   //-----------------------------------
-  message << header_fields_
-          << message_body_;
+  writer.add({"\r\n", 2});
+  writer.add(body_view());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Message::to_iovec(Iovec_list& list) const {
+  for (const auto field : headers()) {
+    list.add(field.first);
+    list.add({": ", 2});
+    list.add(field.second);
+    list.add({"\r\n", 2});
+  }
   //-----------------------------------
-  return message.str();
+  list.add({"\r\n", 2});
+  list.add(body_view());
 }
 
 ///////////////////////////////////////////////////////////////////////////////
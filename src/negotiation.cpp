@@ -0,0 +1,291 @@
+// This file is a part of the IncludeOS unikernel - www.includeos.org
+//
+// Copyright 2015-2016 Oslo and Akershus University College of Applied Sciences
+// and Alfred Bratterud
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <negotiation.hpp>
+
+#include <atomic>
+#include <cstring>
+#include <algorithm>
+
+#include <header_fields.hpp>
+
+namespace http {
+
+//-----------------------------------
+// Marks a cached value that accepts
+// none of the offers
+//-----------------------------------
+static constexpr uint8_t none_cached {0xff};
+
+//-----------------------------------
+// The identifier of the next negotiator,
+// 0 marks an unused cache entry
+//-----------------------------------
+static std::atomic<uint32_t> next_id {1};
+
+///////////////////////////////////////////////////////////////////////////////
+static inline bool is_ows(const char c) noexcept {
+  return c == ' ' or c == '\t';
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static bool equal_ignore_case(const char* lhs, const char* rhs, const size_t len) noexcept {
+  for (size_t i = 0; i < len; ++i) {
+    if (header::fold(lhs[i]) not_eq header::fold(rhs[i])) return false;
+  }
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static uint16_t parse_q(const char*& p, const char* const end) noexcept {
+  unsigned q = 0;
+  //-----------------------------------
+  if (p < end and *p >= '0' and *p <= '9') q = (*p++ - '0') * 1000;
+  //-----------------------------------
+  if (p < end and *p == '.') {
+    ++p;
+    for (unsigned scale = 100; scale not_eq 0 and p < end and *p >= '0' and *p <= '9'; scale /= 10) {
+      q += (*p++ - '0') * scale;
+    }
+  }
+  //-----------------------------------
+  return static_cast<uint16_t>(std::min(q, 1000U));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Preferences::Preferences(const span& value) noexcept {
+  const char*       p   = value.data;
+  const char* const end = value.data + value.len;
+  //-----------------------------------
+  while (p < end) {
+    while (p < end and (is_ows(*p) or *p == ',')) ++p;
+    if (p == end) break;
+    //-----------------------------------
+    const char* token = p;
+    while (p < end and *p not_eq ',' and *p not_eq ';' and not is_ows(*p)) ++p;
+    //-----------------------------------
+    Preference pref {{token, static_cast<size_t>(p - token)}, 1000};
+    //-----------------------------------
+    // Only the q parameter is of interest,
+    // the rest of the element is skipped
+    //-----------------------------------
+    while (p < end and *p not_eq ',') {
+      if (*p++ not_eq ';') continue;
+      while (p < end and is_ows(*p)) ++p;
+      //-----------------------------------
+      if (end - p >= 2 and (p[0] == 'q' or p[0] == 'Q') and p[1] == '=') {
+        p += 2;
+        pref.q = parse_q(p, end);
+      }
+    }
+    //-----------------------------------
+    insert(pref);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Preferences::insert(const Preference& pref) noexcept {
+  size_t at = size_;
+  while (at > 0 and prefs_[at - 1].q < pref.q) --at;
+  //-----------------------------------
+  if (size_ == Capacity) {
+    if (at == Capacity) return;
+    --size_;
+  }
+  //-----------------------------------
+  std::memmove(prefs_ + at + 1, prefs_ + at, (size_ - at) * sizeof(Preference));
+  prefs_[at] = pref;
+  ++size_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Negotiator::Negotiator(const Negotiation kind, std::initializer_list<span> offers) noexcept
+  : kind_{kind}
+  , id_{next_id.fetch_add(1, std::memory_order_relaxed)}
+{
+  for (const auto& token : offers) {
+    if (size_ == Max_offers) break;
+    //-----------------------------------
+    const auto slash = static_cast<const char*>(std::memchr(token.data, '/', token.len));
+    //-----------------------------------
+    offers_[size_++] = {token,
+                        header::hash(token.data, token.len),
+                        static_cast<uint16_t>(slash ? slash - token.data : token.len)};
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static unsigned specificity(const Negotiation kind, const span& range,
+                            const uint32_t range_hash, const span& offer,
+                            const uint32_t offer_hash, const size_t type) noexcept {
+  const bool exact = range_hash == offer_hash
+                     and range.len == offer.len
+                     and equal_ignore_case(range.data, offer.data, range.len);
+  //-----------------------------------
+  switch (kind) {
+    case Negotiation::Media_type:
+      //-----------------------------------
+      // A type/subtype is more specific
+      // than type/* which is more specific
+      // than */*
+      //-----------------------------------
+      if (exact) return 3;
+      if (range.len == 3 and std::memcmp(range.data, "*/*", 3) == 0) return 1;
+      if (range.len == type + 2 and range.data[type] == '/' and range.data[type + 1] == '*'
+          and equal_ignore_case(range.data, offer.data, type))
+      {
+        return 2;
+      }
+      return 0;
+    case Negotiation::Language:
+      //-----------------------------------
+      // A range matches a tag that it is
+      // equal to or a prefix of, the longest
+      // range is the most specific
+      //-----------------------------------
+      if (range.len == 1 and range.data[0] == '*') return 1;
+      if (exact) return 1 + range.len;
+      if (range.len < offer.len and offer.data[range.len] == '-'
+          and equal_ignore_case(range.data, offer.data, range.len))
+      {
+        return 1 + range.len;
+      }
+      return 0;
+    default:
+      if (exact) return 2;
+      return (range.len == 1 and range.data[0] == '*') ? 1 : 0;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Negotiator::qualities(const Preferences& prefs, uint16_t (&q)[Max_offers]) const noexcept {
+  uint32_t hashes[Preferences::Capacity];
+  //-----------------------------------
+  size_t n = 0;
+  for (const auto& pref : prefs) hashes[n++] = header::hash(pref.token.data, pref.token.len);
+  //-----------------------------------
+  for (size_t i = 0; i < size_; ++i) {
+    const auto& offer = offers_[i];
+    //-----------------------------------
+    // The most specific range that matches
+    // decides the quality of an offer
+    //-----------------------------------
+    unsigned best = 0;
+    q[i] = 0;
+    //-----------------------------------
+    n = 0;
+    for (const auto& pref : prefs) {
+      const auto s = specificity(kind_, pref.token, hashes[n++], offer.token, offer.hash, offer.type);
+      if (s > best) {
+        best = s;
+        q[i] = pref.q;
+      }
+    }
+    //-----------------------------------
+    // The identity encoding is acceptable
+    // unless it is excluded, but only if
+    // nothing else is
+    //-----------------------------------
+    if (best == 0 and kind_ == Negotiation::Encoding
+        and offer.token.len == 8 and equal_ignore_case(offer.token.data, "identity", 8))
+    {
+      q[i] = 1;
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Negotiator::Cache_entry& Negotiator::cache_entry(const uint32_t hash) const noexcept {
+  static thread_local Cache_entry cache[Cache_slots];
+  return cache[(hash ^ id_ * 0x9e3779b9U) % Cache_slots];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+size_t Negotiator::select(const span& value) const noexcept {
+  if (value.data == nullptr) return (size_ > 0) ? 0 : npos;
+  //-----------------------------------
+  Cache_entry* entry = nullptr;
+  uint32_t     hash  = 0;
+  //-----------------------------------
+  if (value.len <= Max_cached) {
+    hash  = header::hash(value.data, value.len);
+    entry = &cache_entry(hash);
+    //-----------------------------------
+    if (entry->owner == id_ and entry->hash == hash and entry->len == value.len
+        and std::memcmp(entry->value, value.data, value.len) == 0)
+    {
+      return (entry->result == none_cached) ? npos : entry->result;
+    }
+  }
+  //-----------------------------------
+  uint16_t q[Max_offers];
+  qualities(Preferences{value}, q);
+  //-----------------------------------
+  size_t   result = npos;
+  uint16_t best   = 0;
+  //-----------------------------------
+  for (size_t i = 0; i < size_; ++i) {
+    if (q[i] > best) {
+      best   = q[i];
+      result = i;
+    }
+  }
+  //-----------------------------------
+  if (entry not_eq nullptr) {
+    entry->owner  = id_;
+    entry->hash   = hash;
+    entry->len    = static_cast<uint16_t>(value.len);
+    entry->result = (result == npos) ? none_cached : static_cast<uint8_t>(result);
+    std::memcpy(entry->value, value.data, value.len);
+  }
+  //-----------------------------------
+  return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+span Negotiator::best(const span& value) const noexcept {
+  const auto index = select(value);
+  return (index == npos) ? span{} : offers_[index].token;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+uint32_t Negotiator::acceptable(const span& value) const noexcept {
+  const uint32_t all = (size_ == Max_offers) ? UINT32_MAX : (1U << size_) - 1;
+  if (value.data == nullptr) return all;
+  //-----------------------------------
+  uint16_t q[Max_offers];
+  qualities(Preferences{value}, q);
+  //-----------------------------------
+  uint32_t mask = 0;
+  for (size_t i = 0; i < size_; ++i) {
+    if (q[i] > 0) mask |= 1U << i;
+  }
+  //-----------------------------------
+  return mask;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+span Negotiator::offer(const size_t index) const noexcept {
+  return offers_[index].token;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+size_t Negotiator::size() const noexcept {
+  return size_;
+}
+
+} //< namespace http
@@ -17,27 +17,51 @@
 
 #include <request.hpp>
 
-#include <http_parser.h>
+#include <basic_parser.hpp>
+#include <http_parser_execute.hpp>
 
 namespace http {
 
-static void configure_settings(http_parser_settings&) noexcept;
+//-----------------------------------
+// Make sure the method table follows
+// the codes of the underlying parser
+//-----------------------------------
+#define XX(num, name, string)                                     \
+  static_assert(method::from_parser(num) == name,                 \
+                "http::Method is out of sync with HTTP_METHOD_MAP");
+HTTP_METHOD_MAP(XX)
+#undef XX
 
-static void execute_parser(Request*, http_parser&, http_parser_settings&, const std::string&) noexcept;
+static size_t execute_parser(Request&, http_parser&, char*, const size_t, const Parse_options,
+                             const bool partial_body = true);
 
 ///////////////////////////////////////////////////////////////////////////////
-Request::Request(std::string request, const Limit limit)
+Request::Request(std::string request, const Limit limit, const Parse_options options)
   : Message{limit}
   , request_{std::move(request)}
   , field_{nullptr, 0}
 {
-  http_parser          parser;
-  http_parser_settings settings;
+  http_parser parser;
+  execute_parser(*this, parser, &request_[0], request_.size(), options);
+}
 
-  configure_settings(settings);
-  execute_parser(this, parser, settings, request_);
+///////////////////////////////////////////////////////////////////////////////
+Request::Request(buffer_t buf, const size_t len, const Limit limit, const Parse_options options)
+  : Message{limit}
+  , buffer_{std::move(buf)}
+  , buffer_len_{len}
+  , field_{nullptr, 0}
+{
+  http_parser parser;
+  execute_parser(*this, parser, reinterpret_cast<char*>(buffer_.get()), len, options);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+Request::Request(const Limit limit) noexcept
+  : Message{limit}
+  , field_{nullptr, 0}
+{}
+
 ///////////////////////////////////////////////////////////////////////////////
 Method Request::method() const noexcept {
   return method_;
@@ -80,14 +104,34 @@ Request& Request::reset() noexcept {
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-std::string Request::to_string() const {
-  std::ostringstream request;
+size_t Request::serialized_size() const {
+  return std::strlen(method::str(method_)) + 1 + uri_.size() + 1
+         + Buffer_writer::size_of(version_) + 2
+         + Message::serialized_size();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Request::serialize(Buffer_writer& writer) const {
+  writer.add(method::str(method_));
+  writer.add({" ", 1});
+  writer.add({uri_.data(), uri_.size()});
+  writer.add({" ", 1});
+  writer.add(version_);
+  writer.add({"\r\n", 2});
   //-----------------------------------
-  request << method_ << " "      << uri_
-          << " "     << version_ << "\r\n"
-          << Message::to_string();
+  Message::serialize(writer);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Request::to_iovec(Iovec_list& list) const {
+  list.add(method::str(method_));
+  list.add({" ", 1});
+  list.add({uri_.data(), uri_.size()});
+  list.add({" ", 1});
+  list.add(version_);
+  list.add({"\r\n", 2});
   //-----------------------------------
-  return request.str();
+  Message::to_iovec(list);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -101,55 +145,284 @@ span& Request::field() noexcept {
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-static void configure_settings(http_parser_settings& settings_) noexcept {
-  http_parser_settings_init(&settings_);
+span Request::source() const noexcept {
+  if (buffer_ not_eq nullptr) {
+    return {reinterpret_cast<const char*>(buffer_.get()), buffer_len_};
+  }
+  return {request_.data(), request_.size()};
+}
 
-  settings_.on_message_begin = [](http_parser* parser) {
-    auto req = reinterpret_cast<Request*>(parser->data);
-    req->set_method(
-            http::method::code(
-                http_method_str(static_cast<http_method>(parser->method))));
+//-----------------------------------
+// Handler that fills in a request
+// message from the parser events
+//-----------------------------------
+struct Request_handler : public Parser_handler {
+  Request& req;
+  bool     lazy;
+  bool     in_place_chunks;
+  bool     zero_copy;
+
+  //-----------------------------------
+  // The body can't be larger than the
+  // data given to the parser
+  //-----------------------------------
+  size_t available;
+
+  //-----------------------------------
+  // The body that is referred to within
+  // the data, from the payload of the first
+  // chunk to the end of the last one, which
+  // is compacted in place by <decode_body>
+  //-----------------------------------
+  char* const base;
+  char*       body_begin {nullptr};
+  char*       body_end   {nullptr};
+  size_t      first_len  {0};
+  bool        chunked    {false};
+
+  //-----------------------------------
+  // The header block, when the headers
+  // are indexed lazily
+  //-----------------------------------
+  const char* block_begin {nullptr};
+  const char* block_end   {nullptr};
+
+  //-----------------------------------
+  // The current field is Host, whose
+  // value is recorded in either case
+  //-----------------------------------
+  bool in_host {false};
+
+  //-----------------------------------
+  // The value of the current field, which
+  // is only complete at the next event as
+  // it may be folded over several lines
+  //-----------------------------------
+  char* value_begin {nullptr};
+  char* value_end   {nullptr};
+
+  //-----------------------------------
+  // The header block is complete, so the
+  // fields that follow are trailers which
+  // are added even when indexing lazily
+  //-----------------------------------
+  bool in_trailers {false};
+
+  explicit Request_handler(Request& request, const Parse_options options,
+                           char* data, const size_t len) noexcept
+    : req{request}
+    , lazy{(options & Lazy_headers) not_eq 0}
+    , in_place_chunks{(options & In_place_chunks) not_eq 0}
+    , zero_copy{(options & Zero_copy_body) not_eq 0}
+    , available{len}
+    , base{data}
+  {}
+
+  //-----------------------------------
+  // Check if the body is referred to
+  // instead of copied
+  //-----------------------------------
+  bool view_body(const http_parser& parser) const noexcept {
+    return (parser.flags & F_CHUNKED) ? in_place_chunks : zero_copy;
+  }
+
+  int on_url(http_parser&, const char* at, size_t length) {
+    req.set_uri({at, length});
     return 0;
-  };
+  }
 
-  settings_.on_url = [](http_parser* parser, const char* at, size_t length) {
-    auto req = reinterpret_cast<Request*>(parser->data);
-    req->set_uri({at, length});
+  int on_header_field(http_parser&, const char* at, size_t length) {
+    add_value();
+    in_host = (not in_trailers and length == header::Host.len
+               and header::classify({at, length}) == header::Field_id::Host);
+    if (lazy and not in_trailers) {
+      if (block_begin == nullptr) block_begin = at;
+      return 0;
+    }
+    req.field().data = at;
+    req.field().len  = length;
     return 0;
-  };
+  }
 
-  settings_.on_header_field = [](http_parser* parser, const char* at, size_t length) {
-    auto req = reinterpret_cast<Request*>(parser->data);
-    req->field().data = at;
-    req->field().len  = length;
+  int on_header_value(http_parser&, const char* at, size_t length) noexcept {
+    value_end = base + (at - base) + length;
+    //-----------------------------------
+    // The lines of a folded value are joined
+    // in place, so a lazily indexed block
+    // doesn't contain them either
+    //-----------------------------------
+    if (value_begin == nullptr) {
+      value_begin = base + (at - base);
+    } else {
+      value_begin = base + (unfold_value(value_begin, value_end).data - base);
+    }
+    //-----------------------------------
+    if (lazy and not in_trailers) block_end = value_end;
     return 0;
-  };
+  }
 
-  settings_.on_header_value = [](http_parser* parser, const char* at, size_t length) {
-    auto req = reinterpret_cast<Request*>(parser->data);
-    req->add_header(req->field(), {at, length});
+  int on_headers_complete(http_parser& parser) {
+    add_value();
+    if (block_begin not_eq nullptr) {
+      req.set_header_block({block_begin, static_cast<size_t>(block_end - block_begin)});
+    }
+    in_trailers = true;
+    req.set_method(method::from_parser(parser.method));
+    req.set_version(Version{parser.http_major, parser.http_minor});
+    req.set_info(message_info(parser));
+    if ((parser.flags & F_CONTENTLENGTH) and not view_body(parser)) {
+      req.reserve_body(std::min<uint64_t>(parser.content_length, available));
+    }
     return 0;
-  };
+  }
 
-  settings_.on_body = [](http_parser* parser, const char* at, size_t length) {
-    auto req = reinterpret_cast<Request*>(parser->data);
-    req->add_chunk({at, length});
+  int on_chunk_header(http_parser& parser) {
+    if (view_body(parser)) return 0;
+    req.reserve_body(req.body_view().len
+                     + std::min<uint64_t>(parser.content_length, available));
     return 0;
-  };
+  }
 
-  settings_.on_headers_complete = [](http_parser* parser) {
-    auto req = reinterpret_cast<Request*>(parser->data);
-    req->set_version(Version{parser->http_major, parser->http_minor});
+  int on_body(http_parser& parser, const char* at, size_t length) {
+    if (view_body(parser)) {
+      if (body_begin == nullptr) {
+        body_begin = base + (at - base);
+        first_len  = length;
+        chunked    = (parser.flags & F_CHUNKED) not_eq 0;
+      }
+      body_end = base + (at - base) + length;
+      return 0;
+    }
+    req.append_body({at, length});
     return 0;
-  };
-}
+  }
+
+  //-----------------------------------
+  // Stop at the end of the message so
+  // pipelined requests are left alone
+  //-----------------------------------
+  int on_message_complete(http_parser& parser) {
+    add_value();
+    decode_body();
+    http_parser_pause(&parser, 1);
+    return 0;
+  }
+
+  //-----------------------------------
+  // Add the value of the current field
+  // now that it is complete
+  //-----------------------------------
+  void add_value() {
+    if (value_begin == nullptr) return;
+    //-----------------------------------
+    const span value {value_begin, static_cast<size_t>(value_end - value_begin)};
+    value_begin = nullptr;
+    //-----------------------------------
+    if (in_host) req.set_host(value);
+    if (not lazy or in_trailers) req.add_header(req.field(), value);
+  }
+
+  //-----------------------------------
+  // Move the payload of each chunk over
+  // the chunk-size lines before it
+  //
+  // Until then the data is left as it was
+  // received, so an incomplete message can
+  // be parsed again when the rest arrives
+  //
+  // The framing between the payloads was
+  // accepted by the parser, so it's read
+  // again the way the parser read it
+  //-----------------------------------
+  void decode_body() noexcept {
+    if (body_begin == nullptr) return;
+    //-----------------------------------
+    char*       end  = body_begin;
+    const char* next = body_begin;
+    size_t      size = chunked ? first_len : body_end - body_begin;
+    //-----------------------------------
+    while (true) {
+      size = std::min<size_t>(size, body_end - next);
+      if (end not_eq next) std::memmove(end, next, size);
+      end  += size;
+      next += size;
+      if (next == body_end) break;
+      //-----------------------------------
+      // Skip the CRLF after the payload, the
+      // chunk-size with its extensions and
+      // the CRLF after them
+      //-----------------------------------
+      next += 2;
+      size  = 0;
+      for (bool extension = false; *next not_eq '\r'; ++next) {
+        const auto digit = http_parser_detail::unhex[static_cast<unsigned char>(*next)];
+        if (digit == -1) extension = true;
+        if (not extension) size = size * 16 + digit;
+      }
+      next += 2;
+    }
+    //-----------------------------------
+    req.set_body_view({body_begin, static_cast<size_t>(end - body_begin)});
+    body_begin = nullptr;
+  }
+}; //< struct Request_handler
 
 ///////////////////////////////////////////////////////////////////////////////
-static void execute_parser(Request* req, http_parser& parser, http_parser_settings& settings,
-                           const std::string& data) noexcept {
+static size_t execute_parser(Request& req, http_parser& parser,
+                             char* data, const size_t len, const Parse_options options,
+                             const bool partial_body) {
+  Request_handler handler {req, options, data, len};
   http_parser_init(&parser, HTTP_REQUEST);
-  parser.data = req;
-  http_parser_execute(&parser, &settings, data.data(), data.size());
+  const auto parsed = Basic_parser<Request_handler>::execute(handler, parser, data, len);
+  //-----------------------------------
+  // What was received of an incomplete
+  // message is only kept when nothing
+  // parses the data again
+  //-----------------------------------
+  if (partial_body) {
+    handler.add_value();
+    handler.decode_body();
+  }
+  //-----------------------------------
+  // A received Content-Length field
+  // already describes the entity
+  //-----------------------------------
+  if (not (parser.flags & F_CONTENTLENGTH)) req.complete_body();
+  //-----------------------------------
+  return parsed;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Request_list make_requests(buffer_t buf, const size_t len, size_t& tail, const Limit limit,
+                           const Parse_options options) {
+  Request_list requests;
+  http_parser  parser;
+  //-----------------------------------
+  const auto data = reinterpret_cast<char*>(buf.get());
+  tail = 0;
+  //-----------------------------------
+  while (tail < len) {
+    Request_ptr req {new Request{limit}};
+    req->buffer_     = buf;
+    req->buffer_len_ = len;
+    //-----------------------------------
+    const auto parsed = execute_parser(*req, parser, data + tail, len - tail, options, false);
+    //-----------------------------------
+    // The parser only pauses once it has
+    // seen the end of a message
+    //-----------------------------------
+    if (HTTP_PARSER_ERRNO(&parser) not_eq HPE_PAUSED) break;
+    //-----------------------------------
+    tail += parsed;
+    requests.push_back(std::move(req));
+    //-----------------------------------
+    // The rest of the data belongs to
+    // another protocol
+    //-----------------------------------
+    if (parser.upgrade) break;
+  }
+  //-----------------------------------
+  return requests;
 }
 
 } //< namespace http
@@ -0,0 +1,396 @@
+// This file is a part of the IncludeOS unikernel - www.includeos.org
+//
+// Copyright 2015-2016 Oslo and Akershus University College of Applied Sciences
+// and Alfred Bratterud
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <request_parser.hpp>
+#include <http_parser_execute.hpp>
+
+namespace http {
+
+///////////////////////////////////////////////////////////////////////////////
+Request_parser::Request_parser(const Limit limit, const Parse_options options)
+  : limit_{limit}
+  , options_{options}
+{
+  reset();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Request_parser::Status Request_parser::feed(const char* data, const size_t len) {
+  consumed_ = 0;
+  //-----------------------------------
+  // A length of zero signals EOF to the
+  // underlying parser
+  //-----------------------------------
+  if (data == nullptr or len == 0) return status_;
+  //-----------------------------------
+  switch (status_) {
+    case Status::Need_more: {
+      const auto start = buffer_.size();
+      buffer_.append(data, len);
+      consumed_ = execute(&buffer_[start], len);
+      buffer_.resize(start + consumed_);
+      //---------------------------------
+      if (status_ == Status::Headers_complete
+          or status_ == Status::Message_complete) {
+        materialize();
+      }
+      break;
+    }
+    case Status::Headers_complete:
+      consumed_ = execute(data, len);
+      break;
+    default:
+      break;
+  }
+  //-----------------------------------
+  return status_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Request_parser::Status Request_parser::status() const noexcept {
+  return status_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+size_t Request_parser::consumed() const noexcept {
+  return consumed_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+http_errno Request_parser::error() const noexcept {
+  return HTTP_PARSER_ERRNO(&parser_);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Request_ptr Request_parser::request() const noexcept {
+  return request_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Request_ptr Request_parser::release() {
+  if (status_ not_eq Status::Message_complete) return nullptr;
+  //-----------------------------------
+  auto request = std::move(request_);
+  prepare();
+  //-----------------------------------
+  return request;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Request_parser::reset() {
+  http_parser_init(&parser_, HTTP_REQUEST);
+  consumed_ = 0;
+  prepare();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Request_parser::prepare() {
+  status_ = Status::Need_more;
+  buffer_.clear();
+  request_.reset();
+  url_   = {0, 0};
+  field_ = {0, 0};
+  value_ = {0, 0};
+  last_  = Last::None;
+  fields_.clear();
+  header_count_ = 0;
+  header_end_   = 0;
+  body_.clear();
+  trailer_field_.clear();
+  trailer_value_.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+size_t Request_parser::execute(const char* data, const size_t len) noexcept {
+  input_begin_ = data;
+  input_end_   = data + len;
+  //-----------------------------------
+  const auto parsed = Basic_parser<Request_parser>::execute(*this, parser_, data, len);
+  //-----------------------------------
+  switch (HTTP_PARSER_ERRNO(&parser_)) {
+    case HPE_OK:
+      break;
+    case HPE_PAUSED:
+      http_parser_pause(&parser_, 0);
+      break;
+    default:
+      status_ = Status::Error;
+      break;
+  }
+  //-----------------------------------
+  return parsed;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Request_parser::materialize() {
+  for (const auto& chunk : body_) {
+    request_->append_body({buffer_.data() + chunk.offset, chunk.length});
+  }
+  trim_body();
+  //-----------------------------------
+  request_->request_ = std::move(buffer_);
+  //-----------------------------------
+  const auto base = request_->request_.data();
+  //-----------------------------------
+  request_->set_uri({base + url_.offset, url_.length});
+  //-----------------------------------
+  // The block ends with the last header
+  // field, trailers received with it are
+  // after the body so they are added
+  //-----------------------------------
+  size_t indexed = 0;
+  //-----------------------------------
+  if ((options_ & Lazy_headers) and header_count_ not_eq 0) {
+    const auto& last  = fields_[header_count_ - 1];
+    const auto  begin = fields_.front().first.offset;
+    const auto  end   = last.second.offset + last.second.length;
+    request_->set_header_block({base + begin, end - begin});
+    indexed = header_count_;
+  }
+  //-----------------------------------
+  for (auto field = fields_.begin() + indexed; field not_eq fields_.end(); ++field) {
+    request_->add_header({base + field->first.offset,  field->first.length},
+                         {base + field->second.offset, field->second.length});
+  }
+  //-----------------------------------
+  for (size_t i = 0; i < header_count_; ++i) {
+    const auto& field = fields_[i];
+    if (field.first.length == header::Host.len
+        and header::classify({base + field.first.offset, field.first.length})
+            == header::Field_id::Host)
+    {
+      request_->set_host({base + field.second.offset, field.second.length});
+      break;
+    }
+  }
+  //-----------------------------------
+  // A trailer that is still arriving is
+  // continued in copies
+  //-----------------------------------
+  if (last_ not_eq Last::None) {
+    trailer_field_.assign(base + field_.offset, field_.length);
+    if (last_ == Last::Value) trailer_value_.assign(base + value_.offset, value_.length);
+  }
+  //-----------------------------------
+  if (status_ == Status::Message_complete) complete_body();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Request_parser::trim_body() {
+  //-----------------------------------
+  // Trailers received with the header
+  // block start after the body
+  //-----------------------------------
+  auto trailers = buffer_.size();
+  //-----------------------------------
+  if (fields_.size() > header_count_) {
+    trailers = fields_[header_count_].first.offset;
+  } else if (last_ not_eq Last::None) {
+    trailers = field_.offset;
+  }
+  //-----------------------------------
+  const auto dropped = trailers - header_end_;
+  if (dropped == 0) return;
+  //-----------------------------------
+  buffer_.erase(header_end_, dropped);
+  //-----------------------------------
+  for (auto field = fields_.begin() + header_count_; field not_eq fields_.end(); ++field) {
+    field->first.offset  -= dropped;
+    field->second.offset -= dropped;
+  }
+  if (last_ not_eq Last::None) field_.offset -= dropped;
+  if (last_ == Last::Value)    value_.offset -= dropped;
+  //-----------------------------------
+  // Give the memory back when most of
+  // it held the body
+  //-----------------------------------
+  if (dropped > buffer_.size()) buffer_.shrink_to_fit();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Request_parser::complete_body() {
+  //-----------------------------------
+  // A received Content-Length field
+  // already describes the entity
+  //-----------------------------------
+  if (not (parser_.flags & F_CONTENTLENGTH)) request_->complete_body();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Request_parser::flush_field() {
+  if (last_ not_eq Last::Value) return;
+  //-----------------------------------
+  if (request_->request_.empty()) {
+    fields_.emplace_back(field_, value_);
+  } else {
+    request_->add_header({trailer_field_.data(), trailer_field_.size()},
+                         {trailer_value_.data(), trailer_value_.size()});
+    trailer_field_.clear();
+    trailer_value_.clear();
+  }
+  //-----------------------------------
+  last_ = Last::None;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int Request_parser::on_message_begin(http_parser&) {
+  request_ = Request_ptr{new Request{limit_}};
+  return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int Request_parser::on_url(http_parser&, const char* at, size_t length) noexcept {
+  if (url_.length == 0) url_.offset = at - buffer_.data();
+  url_.length += length;
+  return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int Request_parser::on_header_field(http_parser&, const char* at, size_t length) {
+  flush_field();
+  //-----------------------------------
+  // Trailers that arrive after the header
+  // block was handed over are in fragments
+  // owned by the caller, so they are copied
+  //-----------------------------------
+  if (not request_->request_.empty()) {
+    trailer_field_.append(at, length);
+    last_ = Last::Field;
+    return 0;
+  }
+  //-----------------------------------
+  if (last_ not_eq Last::Field) field_ = {static_cast<size_t>(at - buffer_.data()), 0};
+  field_.length += length;
+  last_ = Last::Field;
+  return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int Request_parser::on_header_value(http_parser&, const char* at, size_t length) {
+  //-----------------------------------
+  // A piece that doesn't pick up where
+  // the last data cut the value off is
+  // a folded line, and the whitespace
+  // that starts it may be cut off too
+  //-----------------------------------
+  const bool folded = (last_ == Last::Value and not (value_cut_ and at == input_begin_));
+  value_cut_ = (at + length == input_end_);
+  //-----------------------------------
+  if (last_ not_eq Last::Value) {
+    unfolding_ = false;
+  } else if (folded) {
+    unfolding_ = true;
+  }
+  //-----------------------------------
+  const auto blank = [&] {
+    for (; length not_eq 0 and (*at == ' ' or *at == '\t'); ++at, --length);
+  };
+  //-----------------------------------
+  // Trailers that arrive after the header
+  // block was handed over are joined with
+  // a space as they are copied
+  //-----------------------------------
+  if (not request_->request_.empty()) {
+    if (folded) trailer_value_ += ' ';
+    if (unfolding_) {
+      blank();
+      unfolding_ = (length == 0);
+    }
+    trailer_value_.append(at, length);
+    last_ = Last::Value;
+    return 0;
+  }
+  //-----------------------------------
+  if (last_ not_eq Last::Value) value_ = {static_cast<size_t>(at - buffer_.data()), 0};
+  //-----------------------------------
+  // A folded value continues after the
+  // line break, so extend to the end and
+  // join the lines in place
+  //-----------------------------------
+  value_.length = (at + length) - (buffer_.data() + value_.offset);
+  const auto value = unfold_value(&buffer_[value_.offset], &buffer_[value_.offset] + value_.length);
+  value_ = {static_cast<size_t>(value.data - buffer_.data()), value.len};
+  //-----------------------------------
+  if (unfolding_) {
+    blank();
+    unfolding_ = (length == 0);
+  }
+  last_ = Last::Value;
+  return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int Request_parser::on_headers_complete(http_parser& parser) {
+  flush_field();
+  header_count_ = fields_.size();
+  //-----------------------------------
+  // Nothing after the last token of the
+  // header block is referred to
+  //-----------------------------------
+  if (header_count_ not_eq 0) {
+    const auto& value = fields_.back().second;
+    header_end_ = value.offset + value.length;
+  } else {
+    header_end_ = url_.offset + url_.length;
+  }
+  request_->set_method(method::from_parser(parser.method));
+  request_->set_version(Version{parser.http_major, parser.http_minor});
+  request_->set_info(message_info(parser));
+  status_ = Status::Headers_complete;
+  return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int Request_parser::on_body(http_parser& parser, const char* at, size_t length) {
+  //-----------------------------------
+  // Until the header block is handed over
+  // the body is remembered by its position
+  //-----------------------------------
+  if (request_->request_.empty()) {
+    body_.push_back({static_cast<size_t>(at - buffer_.data()), length});
+  } else {
+    //---------------------------------
+    // The rest of the entity is reserved
+    // for as it arrives, so a length that
+    // is announced but never sent doesn't
+    // hold on to memory
+    //---------------------------------
+    const uint64_t received = request_->body_view().len + length;
+    request_->reserve_body(std::min(received + parser.content_length, 2 * received));
+    request_->append_body({at, length});
+  }
+  return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int Request_parser::on_message_complete(http_parser& parser) {
+  //-----------------------------------
+  // The last trailer is only known to
+  // be complete here
+  //-----------------------------------
+  flush_field();
+  status_ = Status::Message_complete;
+  //-----------------------------------
+  // Until the header block is handed over
+  // the body is completed by <materialize>
+  //-----------------------------------
+  if (not request_->request_.empty()) complete_body();
+  http_parser_pause(&parser, 1);
+  return 0;
+}
+
+} //< namespace http
@@ -17,13 +17,12 @@
 
 #include <response.hpp>
 
-#include <http_parser.h>
+#include <basic_parser.hpp>
+#include <http_parser_execute.hpp>
 
 namespace http {
 
-static void configure_settings(http_parser_settings&) noexcept;
-
-static void execute_parser(Response*, http_parser&, http_parser_settings&, const std::string&) noexcept;
+static size_t execute_parser(Response&, http_parser&, const char*, const size_t) noexcept;
 
 ///////////////////////////////////////////////////////////////////////////////
 Response::Response(const Code code, const Version version) noexcept
@@ -37,11 +36,19 @@ Response::Response(std::string response, const Limit limit)
   , response_{std::move(response)}
   , field_{nullptr, 0}
 {
-  http_parser          parser;
-  http_parser_settings settings;
+  http_parser parser;
+  execute_parser(*this, parser, response_.data(), response_.size());
+}
 
-  configure_settings(settings);
-  execute_parser(this, parser, settings, response_);
+///////////////////////////////////////////////////////////////////////////////
+Response::Response(buffer_t buf, const size_t len, const Limit limit)
+  : Message{limit}
+  , buffer_{std::move(buf)}
+  , buffer_len_{len}
+  , field_{nullptr, 0}
+{
+  http_parser parser;
+  execute_parser(*this, parser, reinterpret_cast<const char*>(buffer_.get()), len);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -66,21 +73,95 @@ Response& Response::set_version(const Version version) noexcept {
   return *this;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+Response& Response::stamp_date(const bool stamp) noexcept {
+  const auto now = stamp ? time::date() : span{};
+  //-----------------------------------
+  date_len_ = (now.len == time::Date_len) ? now.len : 0;
+  if (date_len_ not_eq 0) std::memcpy(date_, now.data, date_len_);
+  //-----------------------------------
+  return *this;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+span Response::date() const noexcept {
+  return (date_len_ not_eq 0 and not has_header(header::Date)) ? span{date_, date_len_} : span{};
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 Response& Response::reset() noexcept {
   Message::reset();
+  date_len_ = 0;
   return set_status_code(OK);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-std::string Response::to_string() const {
-  std::ostringstream response;
+size_t Response::serialized_size() const {
+  const auto line = status_line(code_, version_);
+  const auto date = this->date();
+  //-----------------------------------
+  const size_t date_field = (date.len not_eq 0) ? header::Date.len + 2 + date.len + 2 : 0;
+  //-----------------------------------
+  if (line.len not_eq 0) return line.len + date_field + Message::serialized_size();
+  //-----------------------------------
+  return date_field + Buffer_writer::size_of(version_) + 1
+         + Buffer_writer::size_of(static_cast<unsigned>(code_)) + 1
+         + std::strlen(code_description(code_)) + 2
+         + Message::serialized_size();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Response::serialize(Buffer_writer& writer) const {
+  const auto line = status_line(code_, version_);
+  //-----------------------------------
+  if (line.len not_eq 0) {
+    writer.add(line);
+  } else {
+    writer.add(version_);
+    writer.add({" ", 1});
+    writer.add(static_cast<unsigned>(code_));
+    writer.add({" ", 1});
+    writer.add(code_description(code_));
+    writer.add({"\r\n", 2});
+  }
+  //-----------------------------------
+  const auto date = this->date();
+  //-----------------------------------
+  if (date.len not_eq 0) {
+    writer.add(header::Date);
+    writer.add({": ", 2});
+    writer.add(date);
+    writer.add({"\r\n", 2});
+  }
+  //-----------------------------------
+  Message::serialize(writer);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Response::to_iovec(Iovec_list& list) const {
+  const auto line = status_line(code_, version_);
   //-----------------------------------
-  response << version_ << " " << code_ << " "
-           << code_description(code_)  << "\r\n"
-           << Message::to_string();
+  if (line.len not_eq 0) {
+    list.add(line);
+  } else {
+    list.add(version_);
+    list.add({" ", 1});
+    list.add(static_cast<unsigned>(code_));
+    list.add({" ", 1});
+    list.add(code_description(code_));
+    list.add({"\r\n", 2});
+  }
+  //-----------------------------------
+  const auto date = this->date();
   //-----------------------------------
-  return response.str();
+  if (date.len not_eq 0) {
+    list.add(header::Date);
+    list.add({": ", 2});
+    list.add(date);
+    list.add({"\r\n", 2});
+  }
+  //-----------------------------------
+  Message::to_iovec(list);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -89,42 +170,77 @@ Response::operator std::string () const {
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-static void configure_settings(http_parser_settings& settings_) noexcept {
-  http_parser_settings_init(&settings_);
+span Response::source() const noexcept {
+  if (buffer_ not_eq nullptr) {
+    return {reinterpret_cast<const char*>(buffer_.get()), buffer_len_};
+  }
+  return {response_.data(), response_.size()};
+}
+
+//-----------------------------------
+// Handler that fills in a response
+// message from the parser events
+//-----------------------------------
+struct Response_handler : public Parser_handler {
+  Response& res;
+
+  //-----------------------------------
+  // The body can't be larger than the
+  // data given to the parser
+  //-----------------------------------
+  size_t available;
+
+  explicit Response_handler(Response& response, const size_t len) noexcept
+    : res{response}
+    , available{len}
+  {}
 
-  settings_.on_header_field = [](http_parser* parser, const char* at, size_t length) {
-    auto res = reinterpret_cast<Response*>(parser->data);
-    res->field().data = at;
-    res->field().len  = length;
+  int on_header_field(http_parser&, const char* at, size_t length) noexcept {
+    res.field().data = at;
+    res.field().len  = length;
     return 0;
-  };
+  }
 
-  settings_.on_header_value = [](http_parser* parser, const char* at, size_t length) {
-    auto res = reinterpret_cast<Response*>(parser->data);
-    res->add_header(res->field(), {at, length});
+  int on_header_value(http_parser&, const char* at, size_t length) {
+    res.add_header(res.field(), {at, length});
     return 0;
-  };
+  }
 
-  settings_.on_body = [](http_parser* parser, const char* at, size_t length) {
-    auto res = reinterpret_cast<Response*>(parser->data);
-    res->add_chunk({at, length});
+  int on_headers_complete(http_parser& parser) noexcept {
+    res.set_version(Version{parser.http_major, parser.http_minor});
+    res.set_status_code(static_cast<status_t>(parser.status_code));
+    res.set_info(message_info(parser));
+    if (parser.flags & F_CONTENTLENGTH) {
+      res.reserve_body(std::min<uint64_t>(parser.content_length, available));
+    }
     return 0;
-  };
+  }
 
-  settings_.on_headers_complete = [](http_parser* parser) {
-    auto res = reinterpret_cast<Response*>(parser->data);
-    res->set_version(Version{parser->http_major, parser->http_minor});
-    res->set_status_code(static_cast<status_t>(parser->status_code));
+  int on_chunk_header(http_parser& parser) {
+    res.reserve_body(res.body_view().len
+                     + std::min<uint64_t>(parser.content_length, available));
     return 0;
-  };
-}
+  }
+
+  int on_body(http_parser&, const char* at, size_t length) {
+    res.append_body({at, length});
+    return 0;
+  }
+}; //< struct Response_handler
 
 ///////////////////////////////////////////////////////////////////////////////
-static void execute_parser(Response* res, http_parser& parser, http_parser_settings& settings,
-                           const std::string& data) noexcept {
+static size_t execute_parser(Response& res, http_parser& parser,
+                             const char* data, const size_t len) noexcept {
+  Response_handler handler {res, len};
   http_parser_init(&parser, HTTP_RESPONSE);
-  parser.data = res;
-  http_parser_execute(&parser, &settings, data.data(), data.size());
+  const auto parsed = Basic_parser<Response_handler>::execute(handler, parser, data, len);
+  //-----------------------------------
+  // A received Content-Length field
+  // already describes the entity
+  //-----------------------------------
+  if (not (parser.flags & F_CONTENTLENGTH)) res.complete_body();
+  //-----------------------------------
+  return parsed;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
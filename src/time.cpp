@@ -17,51 +17,312 @@
 
 #include <time.hpp>
 
+#include <cstdint>
+#include <cstring>
+
 namespace http {
 namespace time {
 
+static constexpr std::time_t seconds_per_day {86400};
+
+//------------------------------------------------
+// The names of the days from Sunday and of the
+// months from January
+//------------------------------------------------
+static constexpr char day_names[]   {"SunMonTueWedThuFriSat"};
+static constexpr char month_names[] {"JanFebMarAprMayJunJulAugSepOctNovDec"};
+
+//------------------------------------------------
+// The full name of each day, as used by RFC 850,
+// past the three letters of the short name
+//------------------------------------------------
+static constexpr const char* day_rests[] {"day", "day", "sday", "nesday", "rsday", "day", "urday"};
+static constexpr uint8_t     day_rest_lens[] {3, 3, 4, 6, 5, 3, 5};
+
+//------------------------------------------------
+// The current time as formatted for a thread
+//------------------------------------------------
+struct Date_cache {
+  std::time_t second {-1};
+  char        text[Date_len];
+};
+
+static thread_local Date_cache date_cache;
+
 ///////////////////////////////////////////////////////////////////////////////
-std::string from_time_t(const std::time_t time_) {
-  auto tm = std::gmtime(&time_);
+// Days since 1970-01-01 of a date in the proleptic Gregorian calendar,
+// counted in eras of 400 years so it holds for any year
+///////////////////////////////////////////////////////////////////////////////
+static std::time_t days_from_civil(long year, const unsigned month, const unsigned day) noexcept {
+  year -= (month <= 2);
+  const long     era = (year >= 0 ? year : year - 399) / 400;
+  const unsigned yoe = static_cast<unsigned>(year - era * 400);
+  const unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return static_cast<std::time_t>(era) * 146097 + doe - 719468;
+}
 
-  if (tm) {
-    std::ostringstream output;
-    output << std::put_time(tm, "%a, %d %b %Y %H:%M:%S %Z");
-    return output.str();
-  }
+///////////////////////////////////////////////////////////////////////////////
+// The inverse of <days_from_civil>
+///////////////////////////////////////////////////////////////////////////////
+static void civil_from_days(std::time_t days, long& year, unsigned& month, unsigned& day) noexcept {
+  days += 719468;
+  const std::time_t era = (days >= 0 ? days : days - 146096) / 146097;
+  const unsigned    doe = static_cast<unsigned>(days - era * 146097);
+  const unsigned    yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const unsigned    doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const unsigned    mp  = (5 * doy + 2) / 153;
+  //-----------------------------------
+  day   = doy - (153 * mp + 2) / 5 + 1;
+  month = mp < 10 ? mp + 3 : mp - 9;
+  year  = static_cast<long>(yoe + era * 400) + (month <= 2);
+}
 
-  return std::string{};
+///////////////////////////////////////////////////////////////////////////////
+static bool is_leap(const long year) noexcept {
+  return (year % 4 == 0 and year % 100 not_eq 0) or year % 400 == 0;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-std::time_t to_time_t(const std::string& time_) {
-  std::tm tm{};
+static unsigned days_in_month(const long year, const unsigned month) noexcept {
+  static constexpr uint8_t days[] {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  return days[month - 1] + (month == 2 and is_leap(year));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static inline void put2(char* out, const unsigned value) noexcept {
+  out[0] = static_cast<char>('0' + value / 10);
+  out[1] = static_cast<char>('0' + value % 10);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+size_t format_date(const std::time_t time_, char* out) noexcept {
+  std::time_t days    = time_ / seconds_per_day;
+  std::time_t seconds = time_ % seconds_per_day;
+  //-----------------------------------
+  if (seconds < 0) {
+    seconds += seconds_per_day;
+    --days;
+  }
+  //-----------------------------------
+  long     year;
+  unsigned month, day;
+  civil_from_days(days, year, month, day);
+  //-----------------------------------
+  if (year < 0 or year > 9999) return 0;
+  //-----------------------------------
+  // 1970-01-01 was a Thursday
+  //-----------------------------------
+  const auto weekday = static_cast<unsigned>(((days % 7) + 11) % 7);
+  const auto second  = static_cast<unsigned>(seconds);
+  //-----------------------------------
+  std::memcpy(out, day_names + weekday * 3, 3);
+  std::memcpy(out + 3, ", ", 2);
+  put2(out + 5, day);
+  out[7] = ' ';
+  std::memcpy(out + 8, month_names + (month - 1) * 3, 3);
+  out[11] = ' ';
+  put2(out + 12, static_cast<unsigned>(year / 100));
+  put2(out + 14, static_cast<unsigned>(year % 100));
+  out[16] = ' ';
+  put2(out + 17, second / 3600);
+  out[19] = ':';
+  put2(out + 20, second / 60 % 60);
+  out[22] = ':';
+  put2(out + 23, second % 60);
+  std::memcpy(out + 25, " GMT", 4);
+  //-----------------------------------
+  return Date_len;
+}
 
-  if (time_.empty()) goto error;
+//------------------------------------------------
+// This class is used to read the fields of a
+// timestamp from the front
+//------------------------------------------------
+class Date_reader {
+public:
+  explicit Date_reader(const span& text) noexcept
+    : p_{text.data}
+    , end_{text.data + text.len}
+  {}
 
-  // Format: Sun, 06 Nov 1994 08:49:37 GMT
-  if (strptime(time_.c_str(), "%a, %d %b %Y %H:%M:%S %Z", &tm) not_eq nullptr) {
-    return std::mktime(&tm);
+  bool literal(const char* text, const size_t len) noexcept {
+    if (static_cast<size_t>(end_ - p_) < len or std::memcmp(p_, text, len) not_eq 0) return false;
+    p_ += len;
+    return true;
   }
 
-  // Format: Sunday, 06-Nov-94 08:49:37 GMT
-  if (strptime(time_.c_str(), "%a, %d-%b-%y %H:%M:%S %Z", &tm) not_eq nullptr) {
-    return std::mktime(&tm);
+  bool number(const size_t digits, unsigned& value) noexcept {
+    if (static_cast<size_t>(end_ - p_) < digits) return false;
+    //-----------------------------------
+    value = 0;
+    for (size_t i = 0; i < digits; ++i, ++p_) {
+      if (*p_ < '0' or *p_ > '9') return false;
+      value = value * 10 + (*p_ - '0');
+    }
+    return true;
   }
 
-  // Format: Sun Nov  6 08:49:37 1994
-  if(strptime(time_.c_str(), "%a %b %d %H:%M:%S %Y", &tm) not_eq nullptr) {
-    return std::mktime(&tm);
+  //-----------------------------------
+  // Index of the three-letter name in
+  // <names>, or <count> if not there
+  //-----------------------------------
+  unsigned name(const char* names, const unsigned count) noexcept {
+    if (end_ - p_ < 3) return count;
+    //-----------------------------------
+    for (unsigned i = 0; i < count; ++i) {
+      if (std::memcmp(p_, names + i * 3, 3) == 0) {
+        p_ += 3;
+        return i;
+      }
+    }
+    return count;
   }
 
-  error:
-  	return std::time_t{};
+  //-----------------------------------
+  // Read "HH:MM:SS"
+  //-----------------------------------
+  bool time_of_day(std::time_t& seconds) noexcept {
+    unsigned hour, minute, second;
+    //-----------------------------------
+    if (not (number(2, hour) and literal(":", 1) and number(2, minute)
+             and literal(":", 1) and number(2, second)))
+    {
+      return false;
+    }
+    //-----------------------------------
+    if (hour > 23 or minute > 59 or second > 60) return false;
+    //-----------------------------------
+    seconds = hour * 3600 + minute * 60 + second;
+    return true;
+  }
+
+  bool done() const noexcept { return p_ == end_; }
+private:
+  const char*       p_;
+  const char* const end_;
+}; //< class Date_reader
+
+///////////////////////////////////////////////////////////////////////////////
+// Interpret a two-digit year as the one nearest to the current year that
+// is at most 50 years in the future, as RFC 7231 §7.1.1.1 requires
+///////////////////////////////////////////////////////////////////////////////
+static long full_year(const unsigned year) noexcept {
+  long     current;
+  unsigned month, day;
+  civil_from_days(std::time(nullptr) / seconds_per_day, current, month, day);
+  //-----------------------------------
+  long result = current - current % 100 + year;
+  if (result > current + 50) result -= 100;
+  return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool parse_date(const span& time_, std::time_t& result) noexcept {
+  if (time_.data == nullptr) return false;
+  //-----------------------------------
+  Date_reader reader {time_};
+  //-----------------------------------
+  const auto weekday = reader.name(day_names, 7);
+  if (weekday == 7) return false;
+  //-----------------------------------
+  long        year;
+  unsigned    month, day, digits;
+  std::time_t seconds;
+  //-----------------------------------
+  // Sun Nov  6 08:49:37 1994
+  //-----------------------------------
+  if (reader.literal(" ", 1)) {
+    month = reader.name(month_names, 12) + 1;
+    if (month == 13 or not reader.literal(" ", 1)) return false;
+    //-----------------------------------
+    if (reader.literal(" ", 1)) {
+      if (not reader.number(1, day)) return false;
+    }
+    else if (not reader.number(2, day)) {
+      return false;
+    }
+    //-----------------------------------
+    if (not (reader.literal(" ", 1) and reader.time_of_day(seconds)
+             and reader.literal(" ", 1) and reader.number(4, digits)))
+    {
+      return false;
+    }
+    year = digits;
+  }
+  //-----------------------------------
+  // Sun, 06 Nov 1994 08:49:37 GMT
+  //-----------------------------------
+  else if (reader.literal(", ", 2)) {
+    if (not (reader.number(2, day) and reader.literal(" ", 1))) return false;
+    //-----------------------------------
+    month = reader.name(month_names, 12) + 1;
+    //-----------------------------------
+    if (month == 13 or not (reader.literal(" ", 1) and reader.number(4, digits)
+                            and reader.literal(" ", 1) and reader.time_of_day(seconds)
+                            and reader.literal(" GMT", 4)))
+    {
+      return false;
+    }
+    year = digits;
+  }
+  //-----------------------------------
+  // Sunday, 06-Nov-94 08:49:37 GMT
+  //-----------------------------------
+  else if (reader.literal(day_rests[weekday], day_rest_lens[weekday]) and reader.literal(", ", 2)) {
+    if (not (reader.number(2, day) and reader.literal("-", 1))) return false;
+    //-----------------------------------
+    month = reader.name(month_names, 12) + 1;
+    //-----------------------------------
+    if (month == 13 or not (reader.literal("-", 1) and reader.number(2, digits)
+                            and reader.literal(" ", 1) and reader.time_of_day(seconds)
+                            and reader.literal(" GMT", 4)))
+    {
+      return false;
+    }
+    year = full_year(digits);
+  }
+  else {
+    return false;
+  }
+  //-----------------------------------
+  if (not reader.done() or day == 0 or day > days_in_month(year, month)) return false;
+  //-----------------------------------
+  result = days_from_civil(year, month, day) * seconds_per_day + seconds;
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+std::string from_time_t(const std::time_t time_) {
+  char text[Date_len];
+  return std::string(text, format_date(time_, text));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+std::time_t to_time_t(const std::string& time_) {
+  std::time_t result;
+  return parse_date({time_.data(), time_.size()}, result) ? result : std::time_t{};
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 std::string now() {
-  auto time_object = std::time(nullptr);
-  return from_time_t(time_object);
+  return date();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+span date() noexcept {
+  auto& cache = date_cache;
+  const auto second = std::time(nullptr);
+  //-----------------------------------
+  if (second not_eq cache.second) {
+    if (format_date(second, cache.text) == 0) {
+      cache.second = -1;
+      return {};
+    }
+    cache.second = second;
+  }
+  //-----------------------------------
+  return {cache.text, Date_len};
 }
 
 } //< namespace time
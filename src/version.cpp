@@ -17,6 +17,8 @@
 
 #include <version.hpp>
 
+#include <buffer_writer.hpp>
+
 namespace http {
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -52,12 +54,12 @@ std::string Version::to_string() const {
 
 ///////////////////////////////////////////////////////////////////////////////
 Version::operator std::string () const {
-  std::ostringstream ver_data;
+  char ver_data[32];
   //----------------------------
-  ver_data << "HTTP/" << major_
-           << "."     << minor_;
- //-----------------------------
-  return ver_data.str();
+  Buffer_writer writer {ver_data, sizeof ver_data};
+  writer.add(*this);
+  //-----------------------------
+  return {ver_data, writer.size()};
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -16,9 +16,13 @@
 // limitations under the License.
 
 #include <iostream>
+#include <algorithm>
 
 #include <request.hpp>
 #include <response.hpp>
+#include <negotiation.hpp>
+#include <request_parser.hpp>
+#include <http_parser_execute.hpp>
 
 int main() {
 
@@ -42,9 +46,199 @@ int main() {
                  "Cache-Control: max-age=0\r\n\r\nb\r\nHello World\r\n5\r\n from\r\n"
                  "a\r\n IncludeOS\r\n0\r\n\r\n"s;
 
-  auto req = http::make_request(move(ingress));
+  //--------------------------------------------------------------
+  // Request arriving in fragments
+  //--------------------------------------------------------------
+  http::Request_parser parser;
+
+  parser.feed(ingress.data(), ingress.size() / 2);
+  parser.feed(ingress.data() + parser.consumed(), ingress.size() - parser.consumed());
+
+  std::cout << parser.release()->get_body() << '\n';
+
+  //--------------------------------------------------------------
+  // Request with its chunked body decoded in place
+  //--------------------------------------------------------------
+  auto req = http::make_request(move(ingress), http::In_place_chunks);
+
+  std::cout << req->body_view() << '\n';
+
+  const auto body = req->get_body();
+  req->own_body();
+
+  std::cout << (body == req->get_body()) << '\n';
+
+  //--------------------------------------------------------------
+  // Request with many chunks decoded in place
+  //--------------------------------------------------------------
+  auto chunks = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"s;
+
+  for (int i = 0; i < 20; ++i) chunks += "1\r\n" + std::to_string(i % 10) + "\r\n";
+  chunks += "0\r\n\r\n";
+
+  std::cout << http::make_request(move(chunks), http::In_place_chunks)->body_view() << '\n';
+
+  //--------------------------------------------------------------
+  // Pipelined requests where the last one is incomplete
+  //--------------------------------------------------------------
+  auto pipelined = "GET / HTTP/1.1\r\n\r\n"
+                   "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+                   "3\r\nabc\r\n2\r\nde"s;
+
+  http::buffer_t buf {new uint8_t[pipelined.size()], std::default_delete<uint8_t[]>()};
+  std::copy(pipelined.begin(), pipelined.end(), buf.get());
+
+  size_t tail;
+  auto requests = http::make_requests(buf, pipelined.size(), tail, 100, http::In_place_chunks);
+
+  std::cout << requests.size() << ' '
+            << std::equal(pipelined.begin() + tail, pipelined.end(), buf.get() + tail) << '\n';
+
+  //--------------------------------------------------------------
+  // A folded field value reads the same however the request
+  // was parsed
+  //--------------------------------------------------------------
+  auto folded = "GET / HTTP/1.1\r\nX-F: a\r\n b\r\n\tc\r\n\r\n"s;
+
+  http::Request_parser folded_parser {100, http::Lazy_headers};
+  folded_parser.feed(folded.data(), folded.size());
+
+  std::cout << http::make_request(folded)->header_value("X-F") << '|'
+            << http::make_request(folded, http::Lazy_headers)->header_value("X-F") << '|'
+            << folded_parser.release()->header_value("X-F") << '\n';
+
+  //--------------------------------------------------------------
+  // Every method known to the parser maps to a method of its own
+  //--------------------------------------------------------------
+  auto methods_mapped = true;
+
+#define XX(num, name, string)                                                 \
+  methods_mapped = methods_mapped                                             \
+    and http::make_request(#string + (num == HTTP_CONNECT ? " a:1"s : " /"s)  \
+                           + " HTTP/1.1\r\n\r\n")->method()                   \
+        == http::method::code(#string)                                        \
+    and http::method::code(#string) not_eq http::INVALID;
+  HTTP_METHOD_MAP(XX)
+#undef XX
+
+  std::cout << methods_mapped << ' '
+            << http::make_request("PROPFIND / HTTP/1.1\r\n\r\n"s)->method() << '\n';
+
+  //--------------------------------------------------------------
+  // More fields than are stored inline, read back after a copy
+  // and after erasing one of the inline ones
+  //--------------------------------------------------------------
+  auto many = "GET / HTTP/1.1\r\n"s;
+
+  for (int i = 0; i < 20; ++i) many += "X-" + std::to_string(i) + ": " + std::to_string(i) + "\r\n";
+  many += "\r\n";
+
+  auto many_fields = *http::make_request(move(many));
+  many_fields.erase_header("X-3");
+
+  std::cout << many_fields.header_size() << ' '
+            << many_fields.header_value("X-19") << ' '
+            << many_fields.has_header("X-3") << '\n';
+
+  //--------------------------------------------------------------
+  // Spans packed into 64 bits keep their base, offset and length,
+  // and a set without buffers keeps its spans aside
+  //--------------------------------------------------------------
+  const http::Compact_span packed {http::Compact_span::Owned, http::Compact_span::Max_offset, 7};
+
+  http::Header standalone;
+  standalone.add_field("A", "one");
+  standalone.set_field("A", "two");
 
-  std::cout << req->get_body() << '\n';
+  std::cout << (packed.base() == http::Compact_span::Owned
+                and packed.offset() == http::Compact_span::Max_offset
+                and packed.len() == 7) << ' '
+            << standalone.get_value("a") << '\n';
+
+  //--------------------------------------------------------------
+  // Each field is found by its name hash wherever it is in the
+  // table, within a block of keys compared at once or after it
+  //--------------------------------------------------------------
+  std::vector<std::string> names;
+
+  for (int i = 0; i < 19; ++i) names.push_back("Field-" + std::to_string(i));
+
+  http::Header table;
+
+  for (const auto& name : names) {
+    table.add_field({name.data(), name.size()}, {name.data() + 6, name.size() - 6});
+  }
+  table.add_field(http::header::Host, "includeos.org");
+
+  auto tabled = true;
+
+  for (const auto& name : names) {
+    auto upper = name;
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+    tabled = tabled and table.get_value({upper.data(), upper.size()}) == name.c_str() + 6;
+  }
+
+  std::cout << tabled << ' ' << table.get_value(http::header::Host) << '\n';
+
+  //--------------------------------------------------------------
+  // Every well-known field is classified whatever its case, and
+  // a name that differs in one byte is not
+  //--------------------------------------------------------------
+  auto classified = true;
+
+#define XX(id, name)                                                          \
+  {                                                                           \
+    std::string upper {name};                                                 \
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);     \
+    classified = classified                                                   \
+      and http::header::classify(http::header::id)                            \
+          == http::header::Field_id::id                                       \
+      and http::header::classify({upper.data(), upper.size()})                \
+          == http::header::Field_id::id;                                      \
+  }
+  HTTP_HEADER_FIELD_MAP(XX)
+#undef XX
+
+  std::cout << classified << ' '
+            << (http::header::classify("Content-Lengtx") == http::header::Field_id::Unknown
+                and http::header::classify("Hos") == http::header::Field_id::Unknown) << '\n';
+
+  //--------------------------------------------------------------
+  // Repeated fields looked up regardless of the case of their
+  // names
+  //--------------------------------------------------------------
+  auto cased = http::make_request("GET / HTTP/1.1\r\n"
+                                  "Set-Cookie: a\r\n"
+                                  "X-Forwarded-Client-Cert-Chain: long\r\n"
+                                  "set-cookie: b\r\n"
+                                  "Set-Cookies: no\r\n"
+                                  "SET-COOKIE: c\r\n\r\n"s);
+
+  for (const auto value : cased->header_values("sEt-CoOkIe")) std::cout << value;
+
+  std::cout << ' ' << cased->header_value("x-forwarded-client-cert-CHAIN") << '\n';
+
+  //--------------------------------------------------------------
+  // Framing and connection recorded while parsing
+  //--------------------------------------------------------------
+  auto sized    = http::make_request("POST / HTTP/1.1\r\nHost: a\r\nConnection: close\r\n"
+                                     "Content-Length: 5\r\n\r\nhello"s);
+  auto upgraded = http::make_request("GET / HTTP/1.1\r\nConnection: Upgrade\r\n"
+                                     "Upgrade: websocket\r\n\r\n"s);
+
+  std::cout << req->keep_alive() << req->is_chunked() << ' ' << req->host() << ' '
+            << sized->keep_alive() << sized->is_chunked() << ' ' << sized->content_length() << ' '
+            << upgraded->is_upgrade() << '\n';
+
+  //--------------------------------------------------------------
+  // Content negotiation against offers compiled once and
+  // shared by every thread
+  //--------------------------------------------------------------
+  static const http::Negotiator encodings {http::Negotiation::Encoding, {"br", "gzip", "identity"}};
+  static const http::Negotiator languages {http::Negotiation::Language, {"en-GB", "ru"}};
+
+  std::cout << encodings.best(req->find_header_value(http::header::Accept_Encoding)) << ' '
+            << languages.best(req->find_header_value(http::header::Accept_Language)) << '\n';
 
   //--------------------------------------------------------------
   // Response
@@ -56,4 +250,132 @@ int main() {
 
   std::cout << res->version() << " " << res->status_code() << '\n'
             << res->header_value("Server") << '\n';
+
+  //--------------------------------------------------------------
+  // Fields sharing a value that was copied into the message
+  //--------------------------------------------------------------
+  res->add_header("X-A", "original"s.c_str());
+  res->add_header("X-B", res->header_value("X-A"));
+  res->set_header("X-B", "zz");
+
+  std::cout << res->header_value("X-A") << ' ' << res->header_value("X-B") << '\n';
+
+  //--------------------------------------------------------------
+  // Every known status has a complete status line for HTTP/1.0
+  // and HTTP/1.1, and other codes and versions have none
+  //--------------------------------------------------------------
+  auto lined = true;
+
+#define XX(code, description)                                                 \
+  for (const unsigned minor : {0, 1}) {                                       \
+    const auto expected = "HTTP/1." + std::to_string(minor) + ' '             \
+                          + #code + ' ' + description + "\r\n";               \
+    lined = lined and http::status_line(code, http::Version{1, minor})        \
+                      == expected.c_str();                                    \
+  }
+  HTTP_STATUS_CODE_MAP(XX)
+#undef XX
+
+  std::cout << lined << ' '
+            << (http::status_line(299, http::Version{1, 1}).is_empty()
+                and http::status_line(200, http::Version{2, 0}).is_empty()) << ' '
+            << http::code_description(299) << '\n';
+
+  //--------------------------------------------------------------
+  // Messages described as pieces for writev read the same as
+  // their string form
+  //--------------------------------------------------------------
+  const auto joined = [](const http::Message& message) {
+    http::Iovec_list list;
+    message.to_iovec(list);
+    std::string text;
+    for (size_t i = 0; i < list.size(); ++i) {
+      text.append(static_cast<const char*>(list.data()[i].iov_base), list.data()[i].iov_len);
+    }
+    return text.size() == list.bytes() and text == message.to_string();
+  };
+
+  res->add_body("Hello");
+
+  std::cout << joined(*req) << joined(many_fields) << joined(*res) << '\n';
+
+  //--------------------------------------------------------------
+  // A stamped response only refers to itself for its Date field,
+  // also once it is copied
+  //--------------------------------------------------------------
+  http::Response stamped;
+  stamped.stamp_date();
+
+  const auto stamped_copy = stamped;
+  const auto copy_begin   = reinterpret_cast<const char*>(&stamped_copy);
+
+  http::Iovec_list stamped_pieces;
+  stamped_copy.to_iovec(stamped_pieces);
+
+  auto date_owned = false;
+
+  for (size_t i = 0; i < stamped_pieces.size(); ++i) {
+    const auto piece = static_cast<const char*>(stamped_pieces.data()[i].iov_base);
+    date_owned = date_owned
+      or (stamped_pieces.data()[i].iov_len == http::time::Date_len
+          and piece >= copy_begin and piece < copy_begin + sizeof stamped_copy);
+  }
+
+  std::cout << date_owned << joined(stamped_copy) << '\n';
+
+  //--------------------------------------------------------------
+  // Messages written into a buffer of exactly their size read
+  // the same as their string form, and don't fit in less
+  //--------------------------------------------------------------
+  const auto serialized = [](const http::Message& message) {
+    std::string text (message.serialized_size(), '\0');
+    std::string short_of (text.size() - 1, '\0');
+    return message.serialize_into(&short_of[0], short_of.size()) == 0
+      and message.serialize_into(&text[0], text.size()) == text.size()
+      and text == message.to_string();
+  };
+
+  std::cout << serialized(*req) << serialized(many_fields) << serialized(*res) << '\n';
+
+  //--------------------------------------------------------------
+  // Timestamps in each of the formats of RFC 7231 read as the
+  // same UTC time, which is formatted back as an IMF-fixdate
+  //--------------------------------------------------------------
+  const std::time_t epoch {784111777};
+
+  auto dated = true;
+
+  for (const auto stamp : {"Sun, 06 Nov 1994 08:49:37 GMT",
+                           "Sunday, 06-Nov-94 08:49:37 GMT",
+                           "Sun Nov  6 08:49:37 1994"}) {
+    std::time_t parsed {0};
+    dated = dated and http::time::parse_date(stamp, parsed) and parsed == epoch;
+  }
+
+  const auto formatted = http::time::from_time_t(epoch);
+
+  std::cout << dated << (http::time::to_time_t(formatted) == epoch) << ' ' << formatted << '\n';
+
+  //--------------------------------------------------------------
+  // The run scanners picked for this CPU stop at the same bytes
+  // as the scalar ones, for every length around the vector widths
+  //--------------------------------------------------------------
+  using namespace http_parser_detail;
+
+  auto scans_alike = true;
+
+  for (const auto stop : {'\r', '\t', ' ', '#', '\x7f', '\xe9'}) {
+    for (size_t len = 0; len <= 66; ++len) {
+      for (size_t at = 0; at <= len; ++at) {
+        std::string run (len, 'a');
+        if (at < len) run[at] = stop;
+        const auto end = run.data() + len;
+        scans_alike = scans_alike
+          and header_value_scanners[scan_level](run.data(), end) == header_value_scanners[0](run.data(), end)
+          and url_scanners[scan_level](run.data(), end) == url_scanners[0](run.data(), end);
+      }
+    }
+  }
+
+  std::cout << scans_alike << '\n';
 }